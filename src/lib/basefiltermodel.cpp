@@ -31,13 +31,18 @@
  */
 
 #include "basefiltermodel.h"
+#include "sourcedata.h"
 
 #include <QtDebug>
 
+#include <algorithm>
+
 BaseFilterModel::BaseFilterModel(QObject *parent)
     : QAbstractListModel(parent)
     , model_(0)
+    , chained_(0)
     , populated_(false)
+    , shareSourceData_(false)
 {
 }
 
@@ -65,6 +70,33 @@ bool BaseFilterModel::populated() const
     return populated_;
 }
 
+void BaseFilterModel::setShareSourceData(bool enabled)
+{
+    if (enabled != shareSourceData_) {
+        shareSourceData_ = enabled;
+
+        if (model_) {
+            // While sharing, changes are received from the shared data once it has discarded the changed rows
+            if (shareSourceData_) {
+                disconnect(model_, &QAbstractItemModel::dataChanged, this, &BaseFilterModel::sourceDataChanged);
+                sourceData_ = SourceData::attach(model_);
+                connect(sourceData_.get(), &SourceData::dataChanged, this, &BaseFilterModel::sourceDataChanged);
+            } else {
+                disconnect(sourceData_.get(), 0, this, 0);
+                sourceData_.reset();
+                connect(model_, &QAbstractItemModel::dataChanged, this, &BaseFilterModel::sourceDataChanged);
+            }
+        }
+
+        emit shareSourceDataChanged();
+    }
+}
+
+bool BaseFilterModel::shareSourceData() const
+{
+    return shareSourceData_;
+}
+
 int BaseFilterModel::rowCount(const QModelIndex &parent) const
 {
     if (parent.isValid())
@@ -89,37 +121,65 @@ QVariant BaseFilterModel::data(const QModelIndex &index, int role) const
     return getRole(index.row(), index.column(), role);
 }
 
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+void BaseFilterModel::multiData(const QModelIndex &index, QModelRoleDataSpan roleDataSpan) const
+{
+    if (index.parent().isValid() || !model_) {
+        for (QModelRoleData &roleData : roleDataSpan) {
+            roleData.clearData();
+        }
+        return;
+    }
+
+    // Forward all the roles to the source model in a single call
+    const QModelIndex sourceIndex(rootIndex(sourceRow(index.row()), index.column()));
+    if (!sourceIndex.isValid()) {
+        for (QModelRoleData &roleData : roleDataSpan) {
+            roleData.clearData();
+        }
+        return;
+    }
+    sourceIndex.model()->multiData(sourceIndex, roleDataSpan);
+}
+#endif
+
 QVariant BaseFilterModel::getRole(int row, int column, const QString &roleName) const
 {
-    auto it = std::find_if(roles_.cbegin(), roles_.cend(), [&roleName](const QPair<int, QByteArray> &pair) { return roleName == pair.second; });
-    if (it == roles_.end())
+    auto it = roleIndices_.constFind(roleName);
+    if (it == roleIndices_.constEnd())
         return QVariant();
 
-    return getRole(row, column, it->first);
+    return getRole(row, column, roles_[*it].first);
 }
 
 QVariant BaseFilterModel::getRole(int row, int column, int role) const
 {
-    return model_->data(model_->index(sourceRow(row), column), role);
+    return rootIndex(sourceRow(row), column).data(role);
 }
 
 QVariantMap BaseFilterModel::getRoles(int row, int column) const
 {
-    QVariantMap rv;
+    return getSourceRoles(sourceRow(row), column, roles_);
+}
 
-    const int source(sourceRow(row));
-    for (auto it = roles_.cbegin(), end = roles_.cend(); it != end; ++it) {
-        QVariant value = getRole(source, column, it->first);
-        if (value.isValid()) {
-            rv.insert(QString::fromUtf8(it->second), value);
+QVariantMap BaseFilterModel::getRoles(int row, int column, const QStringList &roleNames) const
+{
+    std::vector<QPair<int, QByteArray>> roles;
+    roles.reserve(roleNames.count());
+    for (const QString &roleName : roleNames) {
+        auto it = roleIndices_.constFind(roleName);
+        if (it != roleIndices_.constEnd()) {
+            roles.push_back(roles_[*it]);
         }
     }
 
-    return rv;
+    return getSourceRoles(sourceRow(row), column, roles);
 }
 
 void BaseFilterModel::sourceModelReset()
 {
+    // The role names may change when the model is reset
+    updateRoles();
     populateModel();
 }
 
@@ -138,7 +198,14 @@ void BaseFilterModel::sourceRowsInserted(const QModelIndex &parent, int first, i
     if (parent.isValid())
         return;
 
-    sourceItemsInserted(first, (last - first + 1));
+    const int count(last - first + 1);
+    sourceItemsInserted(first, count);
+
+    // Any mapped rows following the insertion point have been displaced
+    for (auto it = mapping_.begin(), end = mapping_.end(); it != end; ++it) {
+        if (*it >= first)
+            *it += count;
+    }
 
     std::vector<int> insertItems;
     for (int i = first; i <= last; ++i)
@@ -148,14 +215,10 @@ void BaseFilterModel::sourceRowsInserted(const QModelIndex &parent, int first, i
     if (insertItems.empty())
         return;
 
-    auto firstIt = std::lower_bound(mapping_.begin(), mapping_.end(), first);
-    const int insertIndex(firstIt - mapping_.begin());
-    const int insertCount(insertItems.size());
+    if (ranked())
+        std::sort(insertItems.begin(), insertItems.end(), [this](int lhs, int rhs) { return lessThan(lhs, rhs); });
 
-    beginInsertRows(QModelIndex(), insertIndex, insertIndex + insertCount - 1);
-    mapping_.insert(firstIt, insertItems.cbegin(), insertItems.cend());
-    itemsInserted(insertIndex, insertCount);
-    endInsertRows();
+    insertMappedItems(insertItems);
 
     emit countChanged();
 }
@@ -165,36 +228,54 @@ void BaseFilterModel::sourceRowsMoved(const QModelIndex &parent, int first, int
     if (parent.isValid() || destination.isValid())
         return;
 
-    auto firstIt = std::lower_bound(mapping_.begin(), mapping_.end(), first);
-    if (firstIt == mapping_.end())
-        return;
+    const int count(last - first + 1);
+    sourceItemsMoved(first, count, row);
 
-    auto destinationIt = std::lower_bound(mapping_.begin(), mapping_.end(), row);
-    if (destinationIt == firstIt)
-        return;
+    // The destination row is specified relative to the items before the move
+    const int destination(row > first ? row - count : row);
+    auto renumber = [first, last, count, destination](int &sourceRow) {
+        if (sourceRow >= first && sourceRow <= last) {
+            sourceRow = destination + (sourceRow - first);
+        } else {
+            if (sourceRow > last)
+                sourceRow -= count;
+            if (sourceRow >= destination)
+                sourceRow += count;
+        }
+    };
 
-    auto lastIt = firstIt;
-    for (auto end = mapping_.end(); lastIt != end; ++lastIt) {
-        if (*lastIt > last)
-            break;
+    if (ranked()) {
+        // Only the relative order of equally ranked items can have changed
+        std::for_each(mapping_.begin(), mapping_.end(), renumber);
+        sortMapping();
+        return;
     }
 
-    if (lastIt == firstIt)
-        return;
+    auto firstIt = std::lower_bound(mapping_.begin(), mapping_.end(), first);
+    auto lastIt = std::lower_bound(firstIt, mapping_.end(), last + 1);
+    auto destinationIt = std::lower_bound(mapping_.begin(), mapping_.end(), row);
 
     const int moveIndex(firstIt - mapping_.begin());
     const int moveCount(lastIt - firstIt);
     const int destinationIndex(destinationIt - mapping_.begin());
 
+    if (moveCount == 0 || destinationIndex == moveIndex || destinationIndex == moveIndex + moveCount) {
+        // The mapped items retain their order
+        std::for_each(mapping_.begin(), mapping_.end(), renumber);
+        return;
+    }
+
     beginMoveRows(QModelIndex(), moveIndex, moveIndex + moveCount - 1, QModelIndex(), destinationIndex);
-    mapping_.erase(firstIt, lastIt);
-    auto insertIt = std::lower_bound(mapping_.begin(), mapping_.end(), row);
-    const int insertIndex(insertIt - mapping_.begin());
-    for (int i = 0; i < moveCount; ++i, ++insertIt) {
-        insertIt = mapping_.insert(insertIt, row + i);
+
+    std::for_each(mapping_.begin(), mapping_.end(), renumber);
+
+    const int insertIndex(destinationIndex > moveIndex ? destinationIndex - moveCount : destinationIndex);
+    if (destinationIndex < moveIndex) {
+        std::rotate(mapping_.begin() + destinationIndex, mapping_.begin() + moveIndex, mapping_.begin() + moveIndex + moveCount);
+    } else {
+        std::rotate(mapping_.begin() + moveIndex, mapping_.begin() + moveIndex + moveCount, mapping_.begin() + destinationIndex);
     }
 
-    sourceItemsMoved(first, (last - first + 1), row);
     itemsMoved(moveIndex, moveCount, insertIndex);
 
     endMoveRows();
@@ -205,28 +286,22 @@ void BaseFilterModel::sourceRowsRemoved(const QModelIndex &parent, int first, in
     if (parent.isValid())
         return;
 
-    auto firstIt = std::lower_bound(mapping_.begin(), mapping_.end(), first);
-    if (firstIt == mapping_.end())
-        return;
+    const int count(last - first + 1);
+    sourceItemsRemoved(first, count);
 
-    auto lastIt = firstIt;
-    for (auto end = mapping_.end(); lastIt != end; ++lastIt) {
-        if (*lastIt > last)
-            break;
+    std::vector<int> removeIndices;
+    for (auto begin = mapping_.begin(), it = begin, end = mapping_.end(); it != end; ++it) {
+        if (*it > last) {
+            *it -= count;
+        } else if (*it >= first) {
+            removeIndices.push_back(it - begin);
+        }
     }
 
-    if (lastIt == firstIt)
+    if (removeIndices.empty())
         return;
 
-    sourceItemsRemoved(first, (last - first + 1));
-
-    const int removeIndex(firstIt - mapping_.begin());
-    const int removeCount(lastIt - firstIt);
-
-    beginRemoveRows(QModelIndex(), removeIndex, removeIndex + removeCount - 1);
-    mapping_.erase(firstIt, lastIt);
-    itemsRemoved(removeIndex, removeCount);
-    endRemoveRows();
+    removeMappedItems(removeIndices);
 
     emit countChanged();
 }
@@ -237,20 +312,42 @@ void BaseFilterModel::sourceDataChanged(const QModelIndex &topLeft, const QModel
         return;
 
     const int first(topLeft.row());
-    auto firstIt = std::lower_bound(mapping_.begin(), mapping_.end(), first);
-    if (firstIt == mapping_.end())
+    const int last(bottomRight.row());
+    sourceItemsChanged(first, (last - first + 1));
+
+    // The changed items may now be included or excluded
+    if (filtered()) {
+        updateMapping(first, last);
+    }
+
+    if (ranked()) {
+        int firstIndex = -1;
+        int lastIndex = -1;
+        for (auto begin = mapping_.cbegin(), it = begin, end = mapping_.cend(); it != end; ++it) {
+            if (*it >= first && *it <= last) {
+                const int mappedIndex(it - begin);
+                if (firstIndex == -1 || mappedIndex < firstIndex)
+                    firstIndex = mappedIndex;
+                lastIndex = qMax(lastIndex, mappedIndex);
+            }
+        }
+        if (firstIndex == -1)
+            return;
+
+        itemsChanged(firstIndex, (lastIndex - firstIndex + 1));
+
+        emit dataChanged(index(firstIndex, topLeft.column()), index(lastIndex, bottomRight.column()), roles);
         return;
-    
-    const int firstIndex(firstIt - mapping_.begin());
+    }
 
-    const int last(bottomRight.row());
-    auto lastIt = std::lower_bound(mapping_.begin(), mapping_.end(), last);
+    auto firstIt = std::lower_bound(mapping_.begin(), mapping_.end(), first);
+    auto lastIt = std::upper_bound(firstIt, mapping_.end(), last);
+    if (firstIt == lastIt)
+        return;
 
-    int lastIndex(lastIt - mapping_.begin());
-    if (lastIt != mapping_.end() && *lastIt == last)
-        ++lastIndex;
+    const int firstIndex(firstIt - mapping_.begin());
+    const int lastIndex((lastIt - mapping_.begin()) - 1);
 
-    sourceItemsChanged(first, (last - first + 1));
     itemsChanged(firstIndex, (lastIndex - firstIndex + 1));
 
     emit dataChanged(index(firstIndex, topLeft.column()), index(lastIndex, bottomRight.column()), roles);
@@ -280,6 +377,19 @@ void BaseFilterModel::populateModel()
         emit countChanged();
 }
 
+void BaseFilterModel::resetMapping()
+{
+    // Rebuild the mapping without discarding any state held for the source items
+    const size_t previousCount(mapping_.size());
+
+    beginResetModel();
+    buildMapping(false);
+    endResetModel();
+
+    if (previousCount != mapping_.size())
+        emit countChanged();
+}
+
 void BaseFilterModel::buildMapping(bool reportChanges)
 {
     // TODO: synchronize_lists would be useful here
@@ -300,11 +410,15 @@ void BaseFilterModel::buildMapping(bool reportChanges)
         std::vector<int> insertItems;
         insertItems.reserve(sourceItemCount);
         if (filtered()) {
+            evaluateItems();
             for (int i = 0, n = model_->rowCount(); i < n; ++i) {
                 if (includeItem(i)) {
                     insertItems.push_back(i);
                 }
             }
+            if (ranked()) {
+                std::stable_sort(insertItems.begin(), insertItems.end(), [this](int lhs, int rhs) { return lessThan(lhs, rhs); });
+            }
         } else {
             insertItems.resize(sourceItemCount);
             std::iota(insertItems.begin(), insertItems.end(), 0);
@@ -332,6 +446,8 @@ void BaseFilterModel::refineMapping()
 {
     std::vector<int> removeIndices;
 
+    evaluateItems();
+
     // Test if any of the current items should now be excluded
     for (auto begin = mapping_.begin(), it = begin, end = mapping_.end(); it != end; ++it) {
         if (!includeItem(*it)) {
@@ -340,36 +456,31 @@ void BaseFilterModel::refineMapping()
     }
 
     if (!removeIndices.empty()) {
-        std::reverse(removeIndices.begin(), removeIndices.end());
-        for (auto it = removeIndices.cbegin(), end = removeIndices.cend(); it != end; ) {
-            auto rangeLast = it, rangeFirst = rangeLast;
-            for (auto next = it + 1; next != end; ++next) {
-                if (*next == (*rangeFirst - 1)) {
-                    rangeFirst = next;
-                } else {
-                    break;
-                }
-            }
-
-            // Remove this range
-            int removeIndex = *rangeFirst;
-            int removeCount = (*rangeLast - *rangeFirst + 1);
-            beginRemoveRows(QModelIndex(), removeIndex, removeIndex + removeCount - 1);
-            mapping_.erase(mapping_.begin() + removeIndex, mapping_.begin() + removeIndex + removeCount);
-            itemsRemoved(removeIndex, removeCount);
-            endRemoveRows();
+        removeMappedItems(removeIndices);
+    }
 
-            it += removeCount;
-        }
+    if (ranked()) {
+        // Rankings may change for the items that remain
+        sortMapping();
+    }
 
+    if (!removeIndices.empty()) {
         emit countChanged();
     }
 }
 
 void BaseFilterModel::unrefineMapping()
 {
+    if (ranked()) {
+        // Re-rank the retained items before inserting those now included
+        updateMapping(0, model_->rowCount() - 1);
+        return;
+    }
+
     std::vector<std::pair<int, std::vector<int>>> insertIndices;
 
+    evaluateItems();
+
     // Test if any of the currently excluded items should now be included
     std::vector<int> include;
     int lastIndex = -1;
@@ -418,13 +529,167 @@ void BaseFilterModel::unrefineMapping()
     }
 }
 
+void BaseFilterModel::updateMapping(int first, int last)
+{
+    // Include or exclude each source item in the range, as the filter now requires
+    evaluateItems();
+
+    // Find the mapped index of each item
+    std::vector<int> indices(last - first + 1, -1);
+    if (ranked()) {
+        for (auto begin = mapping_.cbegin(), it = begin, end = mapping_.cend(); it != end; ++it) {
+            if (*it >= first && *it <= last) {
+                indices[*it - first] = it - begin;
+            }
+        }
+    } else {
+        auto firstIt = std::lower_bound(mapping_.cbegin(), mapping_.cend(), first);
+        for (auto it = firstIt, end = mapping_.cend(); it != end && *it <= last; ++it) {
+            indices[*it - first] = it - mapping_.cbegin();
+        }
+    }
+
+    std::vector<int> removeIndices;
+    std::vector<int> insertItems;
+    for (int sourceRow = first; sourceRow <= last; ++sourceRow) {
+        const int index(indices[sourceRow - first]);
+        const bool include(includeItem(sourceRow));
+        if (index != -1 && !include) {
+            removeIndices.push_back(index);
+        } else if (index == -1 && include) {
+            insertItems.push_back(sourceRow);
+        }
+    }
+
+    if (!removeIndices.empty()) {
+        std::sort(removeIndices.begin(), removeIndices.end());
+        removeMappedItems(removeIndices);
+    }
+
+    if (ranked()) {
+        // The retained items may have been re-scored
+        sortMapping();
+    }
+
+    if (!insertItems.empty()) {
+        if (ranked())
+            std::sort(insertItems.begin(), insertItems.end(), [this](int lhs, int rhs) { return lessThan(lhs, rhs); });
+
+        insertMappedItems(insertItems);
+    }
+
+    if (!removeIndices.empty() || !insertItems.empty()) {
+        emit countChanged();
+    }
+}
+
+void BaseFilterModel::sortMapping()
+{
+    auto compare = [this](int lhs, int rhs) { return lessThan(lhs, rhs); };
+    if (std::is_sorted(mapping_.cbegin(), mapping_.cend(), compare))
+        return;
+
+    emit layoutAboutToBeChanged(QList<QPersistentModelIndex>(), QAbstractItemModel::VerticalSortHint);
+
+    const std::vector<int> previousMapping(mapping_);
+    std::stable_sort(mapping_.begin(), mapping_.end(), compare);
+
+    const QModelIndexList previousIndices(persistentIndexList());
+    if (!previousIndices.isEmpty()) {
+        // Find the new index of each mapped source row
+        std::vector<int> indices(model_->rowCount(), -1);
+        for (auto begin = mapping_.cbegin(), it = begin, end = mapping_.cend(); it != end; ++it) {
+            indices[*it] = it - begin;
+        }
+
+        QModelIndexList currentIndices;
+        currentIndices.reserve(previousIndices.count());
+        for (const QModelIndex &previous : previousIndices) {
+            currentIndices.append(index(indices[previousMapping[previous.row()]], previous.column()));
+        }
+        changePersistentIndexList(previousIndices, currentIndices);
+    }
+
+    emit layoutChanged(QList<QPersistentModelIndex>(), QAbstractItemModel::VerticalSortHint);
+}
+
+void BaseFilterModel::insertMappedItems(const std::vector<int> &insertItems)
+{
+    // Group the items by their insertion point in the existing mapping
+    std::vector<std::pair<int, std::vector<int>>> insertIndices;
+    for (auto it = insertItems.cbegin(), end = insertItems.cend(); it != end; ++it) {
+        auto insertIt = std::upper_bound(mapping_.cbegin(), mapping_.cend(), *it, [this](int lhs, int rhs) { return lessThan(lhs, rhs); });
+        const int insertIndex(insertIt - mapping_.cbegin());
+        if (insertIndices.empty() || insertIndices.back().first != insertIndex) {
+            insertIndices.push_back(std::make_pair(insertIndex, std::vector<int>()));
+        }
+        insertIndices.back().second.push_back(*it);
+    }
+
+    // Insert from the end, so that the preceding insertion indices remain valid
+    for (auto it = insertIndices.crbegin(), end = insertIndices.crend(); it != end; ++it) {
+        const int insertIndex = it->first;
+        const std::vector<int> &items = it->second;
+        const int insertCount = items.size();
+
+        beginInsertRows(QModelIndex(), insertIndex, insertIndex + insertCount - 1);
+        mapping_.insert(mapping_.begin() + insertIndex, items.cbegin(), items.cend());
+        itemsInserted(insertIndex, insertCount);
+        endInsertRows();
+    }
+}
+
+void BaseFilterModel::removeMappedItems(const std::vector<int> &removeIndices)
+{
+    // Remove contiguous ranges, starting from the end
+    for (auto it = removeIndices.crbegin(), end = removeIndices.crend(); it != end; ) {
+        auto rangeLast = it, rangeFirst = rangeLast;
+        for (auto next = it + 1; next != end; ++next) {
+            if (*next == (*rangeFirst - 1)) {
+                rangeFirst = next;
+            } else {
+                break;
+            }
+        }
+
+        // Remove this range
+        int removeIndex = *rangeFirst;
+        int removeCount = (*rangeLast - *rangeFirst + 1);
+        beginRemoveRows(QModelIndex(), removeIndex, removeIndex + removeCount - 1);
+        mapping_.erase(mapping_.begin() + removeIndex, mapping_.begin() + removeIndex + removeCount);
+        itemsRemoved(removeIndex, removeCount);
+        endRemoveRows();
+
+        it += removeCount;
+    }
+}
+
 int BaseFilterModel::sourceRow(int row) const
 {
     return mapping_.at(row);
 }
 
+QModelIndex BaseFilterModel::rootIndex(int sourceRow, int column) const
+{
+    // Compose the mappings of any chained filter models, rather than reading through each of them
+    const BaseFilterModel *model(this);
+    while (model->chained_) {
+        model = model->chained_;
+        if (sourceRow < 0 || sourceRow >= int(model->mapping_.size()))
+            return QModelIndex();
+        sourceRow = model->mapping_[sourceRow];
+    }
+
+    return model->model_ ? model->model_->index(sourceRow, column) : QModelIndex();
+}
+
 int BaseFilterModel::indexForSourceRow(int sourceRow) const
 {
+    if (ranked()) {
+        auto it = std::find(mapping_.cbegin(), mapping_.cend(), sourceRow);
+        return it == mapping_.cend() ? -1 : (it - mapping_.cbegin());
+    }
+
     auto it = std::lower_bound(mapping_.cbegin(), mapping_.cend(), sourceRow);
     return (it == mapping_.end() || *it != sourceRow) ? -1 : (it - mapping_.cbegin());
 }
@@ -432,7 +697,10 @@ int BaseFilterModel::indexForSourceRow(int sourceRow) const
 void BaseFilterModel::setModel(QAbstractItemModel *model)
 {
     if (model_) {
-        disconnect(model_);
+        disconnect(model_, 0, this, 0);
+    }
+    if (sourceData_) {
+        disconnect(sourceData_.get(), 0, this, 0);
     }
 
     sourceItemsCleared();
@@ -441,23 +709,30 @@ void BaseFilterModel::setModel(QAbstractItemModel *model)
     objectGet_ = QMetaMethod();
     populated_ = false;
     roles_.clear();
+    roleIndices_.clear();
     mapping_.clear();
     itemsCleared();
 
     model_ = model;
+    chained_ = qobject_cast<BaseFilterModel *>(model);
+    sourceData_.reset();
     if (model_) {
+        if (shareSourceData_) {
+            sourceData_ = SourceData::attach(model_);
+        }
+
         connect(model_, &QAbstractItemModel::modelReset, this, &BaseFilterModel::sourceModelReset);
         connect(model_, &QAbstractItemModel::rowsInserted, this, &BaseFilterModel::sourceRowsInserted);
         connect(model_, &QAbstractItemModel::rowsMoved, this, &BaseFilterModel::sourceRowsMoved);
         connect(model_, &QAbstractItemModel::rowsRemoved, this, &BaseFilterModel::sourceRowsRemoved);
-        connect(model_, &QAbstractItemModel::dataChanged, this, &BaseFilterModel::sourceDataChanged);
+        if (sourceData_) {
+            connect(sourceData_.get(), &SourceData::dataChanged, this, &BaseFilterModel::sourceDataChanged);
+        } else {
+            connect(model_, &QAbstractItemModel::dataChanged, this, &BaseFilterModel::sourceDataChanged);
+        }
         connect(model_, &QAbstractItemModel::layoutChanged, this, &BaseFilterModel::sourceLayoutChanged);
 
-        const QHash<int, QByteArray> &roles(model_->roleNames());
-        roles_.reserve(roles.size());
-        for (auto it = roles.cbegin(), end = roles.cend(); it != end; ++it) {
-            roles_.push_back(qMakePair(it.key(), it.value()));
-        }
+        updateRoles();
 
         // Find the 'populated' property in this model, if present
         const QMetaObject *mo(model_->metaObject());
@@ -478,7 +753,15 @@ void BaseFilterModel::setModel(QAbstractItemModel *model)
 
 QVariant BaseFilterModel::getSourceValue(int sourceRow, int role) const
 {
-    return model_->data(model_->index(sourceRow, 0), role);
+    QVariant rv;
+    if (sourceData_ && sourceData_->findValue(sourceRow, role, &rv))
+        return rv;
+
+    rv = rootIndex(sourceRow, 0).data(role);
+    if (sourceData_) {
+        sourceData_->insertValue(sourceRow, role, rv);
+    }
+    return rv;
 }
 
 QVariant BaseFilterModel::getSourceValue(int sourceRow, const QMetaProperty &property) const
@@ -491,21 +774,67 @@ QVariant BaseFilterModel::getSourceValue(int sourceRow, const QMetaProperty &pro
     return QVariant();
 }
 
-int BaseFilterModel::findRole(const QString &roleName) const
+void BaseFilterModel::updateRoles()
 {
+    roles_.clear();
+    roleIndices_.clear();
+
     if (model_) {
-        const QHash<int, QByteArray> &roles = model_->roleNames();
+        const QHash<int, QByteArray> roles(model_->roleNames());
+        roles_.reserve(roles.size());
+        roleIndices_.reserve(roles.size());
         for (auto it = roles.cbegin(), end = roles.cend(); it != end; ++it) {
-            if (it.value() == roleName) {
-                return it.key();
-            }
+            roleIndices_.insert(QString::fromUtf8(it.value()), int(roles_.size()));
+            roles_.push_back(qMakePair(it.key(), it.value()));
         }
     }
+}
+
+int BaseFilterModel::findRole(const QString &roleName) const
+{
+    auto it = roleIndices_.constFind(roleName);
+    if (it != roleIndices_.constEnd()) {
+        return roles_[*it].first;
+    }
 
     qWarning() << "No matching role in model:" << roleName;
     return -1;
 }
 
+QVariantMap BaseFilterModel::getSourceRoles(int sourceRow, int column, const std::vector<QPair<int, QByteArray>> &roles) const
+{
+    QVariantMap rv;
+
+    const QModelIndex index(rootIndex(sourceRow, column));
+    if (!index.isValid())
+        return rv;
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    // Fetch all the roles in a single call
+    std::vector<QModelRoleData> data;
+    data.reserve(roles.size());
+    for (auto it = roles.cbegin(), end = roles.cend(); it != end; ++it) {
+        data.emplace_back(it->first);
+    }
+    index.model()->multiData(index, QModelRoleDataSpan(data));
+
+    for (size_t i = 0; i < roles.size(); ++i) {
+        if (data[i].data().isValid()) {
+            rv.insert(QString::fromUtf8(roles[i].second), data[i].data());
+        }
+    }
+#else
+    for (auto it = roles.cbegin(), end = roles.cend(); it != end; ++it) {
+        const QVariant value(index.data(it->first));
+        if (value.isValid()) {
+            rv.insert(QString::fromUtf8(it->second), value);
+        }
+    }
+#endif
+
+    return rv;
+}
+
 QMetaProperty BaseFilterModel::findProperty(const QByteArray &propertyName) const
 {
     QMetaProperty property;
@@ -534,6 +863,22 @@ QMetaProperty BaseFilterModel::findProperty(const QByteArray &propertyName) cons
     return property;
 }
 
+void BaseFilterModel::evaluateItems() const
+{
+    // Invoked before includeItem() is tested for many items, so that derived types may
+    // evaluate their criteria for all items together
+}
+
+bool BaseFilterModel::ranked() const
+{
+    return false;
+}
+
+bool BaseFilterModel::lessThan(int lhsSourceRow, int rhsSourceRow) const
+{
+    return lhsSourceRow < rhsSourceRow;
+}
+
 void BaseFilterModel::sourceItemsInserted(int, int) {}
 void BaseFilterModel::itemsInserted(int, int) {}
 void BaseFilterModel::sourceItemsMoved(int, int, int) {}
@@ -38,13 +38,17 @@
 #include <QAbstractListModel>
 #include <QMetaProperty>
 
+#include <memory>
 #include <vector>
 
+class SourceData;
+
 class NEMO_QML_PLUGIN_MODELS_EXPORT BaseFilterModel : public QAbstractListModel
 {
     Q_OBJECT
     Q_PROPERTY(QObject *sourceModel READ sourceModel WRITE setSourceModel NOTIFY sourceModelChanged)
     Q_PROPERTY(bool populated READ populated NOTIFY populatedChanged)
+    Q_PROPERTY(bool shareSourceData READ shareSourceData WRITE setShareSourceData NOTIFY shareSourceDataChanged)
     Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
 
 public:
@@ -55,17 +59,26 @@ public:
 
     bool populated() const;
 
+    void setShareSourceData(bool enabled);
+    bool shareSourceData() const;
+
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
     QHash<int, QByteArray> roleNames() const override;
-    QVariant data(const QModelIndex &index, int role) const override;
+    // Reads are composed through chained filter models, so data cannot be altered by a subclass
+    QVariant data(const QModelIndex &index, int role) const final;
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    void multiData(const QModelIndex &index, QModelRoleDataSpan roleDataSpan) const final;
+#endif
 
     Q_INVOKABLE QVariant getRole(int row, int column, const QString &roleName) const;
     Q_INVOKABLE QVariant getRole(int row, int column, int role) const;
     Q_INVOKABLE QVariantMap getRoles(int row, int column) const;
+    Q_INVOKABLE QVariantMap getRoles(int row, int column, const QStringList &roleNames) const;
 
 signals:
     void sourceModelChanged();
     void populatedChanged();
+    void shareSourceDataChanged();
     void countChanged();
 
 protected slots:
@@ -79,23 +92,36 @@ protected slots:
 
 protected:
     void populateModel();
+    void updateRoles();
+    void resetMapping();
 
     void buildMapping(bool reportChanges = true);
     void refineMapping();
     void unrefineMapping();
 
+    void updateMapping(int first, int last);
+    void sortMapping();
+    void insertMappedItems(const std::vector<int> &insertItems);
+    void removeMappedItems(const std::vector<int> &removeIndices);
+
     int sourceRow(int row) const;
     int indexForSourceRow(int sourceRow) const;
+    QModelIndex rootIndex(int sourceRow, int column) const;
 
     virtual void setModel(QAbstractItemModel *model);
 
     virtual bool filtered() const = 0;
     virtual bool includeItem(int sourceRow) const = 0;
+    virtual void evaluateItems() const;
+
+    virtual bool ranked() const;
+    virtual bool lessThan(int lhsSourceRow, int rhsSourceRow) const;
 
     QVariant getSourceValue(int sourceRow, int role) const;
     QVariant getSourceValue(int sourceRow, const QMetaProperty &property) const;
 
     int findRole(const QString &roleName) const;
+    QVariantMap getSourceRoles(int sourceRow, int column, const std::vector<QPair<int, QByteArray>> &roles) const;
     QMetaProperty findProperty(const QByteArray &propertyName) const;
 
     virtual void sourceItemsInserted(int insertIndex, int insertCount);
@@ -114,11 +140,17 @@ protected:
     virtual void itemsCleared();
 
     QAbstractItemModel *model_;
+    // The source model, where it is a filter model; data is then read through its mapping directly
+    const BaseFilterModel *chained_;
     QMetaProperty modelPopulated_;
     QMetaMethod objectGet_;
     bool populated_;
+    bool shareSourceData_;
+    // Role values read from the source, shared with the other filter models of the source
+    std::shared_ptr<SourceData> sourceData_;
     std::vector<int> mapping_;
     std::vector<QPair<int, QByteArray>> roles_;
+    QHash<QString, int> roleIndices_;
 };
 
 #endif // BASEFILTERMODEL_H
@@ -178,6 +178,35 @@ QVariant CompositeModel::data(const QModelIndex &index, int role) const
     return QVariant();
 }
 
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+void CompositeModel::multiData(const QModelIndex &index, QModelRoleDataSpan roleDataSpan) const
+{
+    if (index.isValid()) {
+        int row = index.row();
+        for (auto it = m_models.cbegin(), end = m_models.cend(); it != end; ++it) {
+            if (row < (*it)->rowCount()) {
+                // Forward all the roles to the source model, then supply the source model role
+                (*it)->multiData((*it)->index(row, index.column()), roleDataSpan);
+                if (m_sourceModelRole != -1) {
+                    for (QModelRoleData &roleData : roleDataSpan) {
+                        if (roleData.role() == m_sourceModelRole) {
+                            roleData.setData((*it)->objectName());
+                        }
+                    }
+                }
+                return;
+            } else {
+                row -= (*it)->rowCount();
+            }
+        }
+    }
+
+    for (QModelRoleData &roleData : roleDataSpan) {
+        roleData.clearData();
+    }
+}
+#endif
+
 QHash<int, QByteArray> CompositeModel::roleNames() const
 {
     QHash<int, QByteArray> roles;
@@ -56,6 +56,9 @@ public:
 
     int rowCount(const QModelIndex &parent = QModelIndex()) const;
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    void multiData(const QModelIndex &index, QModelRoleDataSpan roleDataSpan) const;
+#endif
     QHash<int, QByteArray> roleNames() const;
 
 signals:
@@ -33,9 +33,14 @@
 
 #include "filtermodel.h"
 
+#include <QDateTime>
 #include <QRegularExpression>
 #include <QSequentialIterable>
 #include <QtDebug>
+#include <QtNumeric>
+
+#include <algorithm>
+#include <cmath>
 
 namespace {
 
@@ -55,6 +60,10 @@ const std::vector<QPair<QString, QPair<FilterModel::Comparator, bool>>> &compara
         details.push_back(qMakePair(QStringLiteral("!contains"), qMakePair(FilterModel::ElementEqual, true)));
         details.push_back(qMakePair(QStringLiteral("elementMatch"), qMakePair(FilterModel::ElementHasMatch, false)));
         details.push_back(qMakePair(QStringLiteral("!elementMatch"), qMakePair(FilterModel::ElementHasMatch, true)));
+        details.push_back(qMakePair(QStringLiteral("in"), qMakePair(FilterModel::In, false)));
+        details.push_back(qMakePair(QStringLiteral("!in"), qMakePair(FilterModel::In, true)));
+        details.push_back(qMakePair(QStringLiteral("between"), qMakePair(FilterModel::Between, false)));
+        details.push_back(qMakePair(QStringLiteral("!between"), qMakePair(FilterModel::Between, true)));
     }
     return details;
 }
@@ -81,9 +90,228 @@ QString comparatorName(const QPair<FilterModel::Comparator, bool> &comparatorTyp
     return QString();
 }
 
+// The relative cost of evaluating a filter with each comparator
+int comparatorCost(FilterModel::Comparator comparator)
+{
+    switch (comparator) {
+    case FilterModel::None:
+        return 0;
+    case FilterModel::Equal:
+    case FilterModel::LessThan:
+    case FilterModel::LessThanEqual:
+    case FilterModel::In:
+    case FilterModel::Between:
+        return 1;
+    case FilterModel::ElementEqual:
+        return 2;
+    case FilterModel::HasMatch:
+        return 4;
+    case FilterModel::ElementHasMatch:
+        return 8;
+    }
+    return 1;
+}
+
+template<typename Container>
+std::vector<int> evaluationOrder(const Container &filters)
+{
+    std::vector<int> rv(filters.size());
+    for (size_t i = 0; i < rv.size(); ++i) {
+        rv[i] = i;
+    }
+    std::stable_sort(rv.begin(), rv.end(), [&filters](int lhs, int rhs) { return filters[lhs].cost_ < filters[rhs].cost_; });
+    return rv;
+}
+
+template<typename Container, typename Function>
+void forEachLeaf(Container &filters, Function function)
+{
+    for (auto &filter : filters) {
+        if (filter.group_) {
+            forEachLeaf(filter.children_, function);
+        } else {
+            function(filter);
+        }
+    }
+}
+
+// Source values of the types compared by FilterData::IntegerValue and FilterData::RealValue
+template<typename T>
+const T &valueData(const QVariant &value)
+{
+    return *static_cast<const T *>(value.constData());
+}
+
+qint64 integerData(const QVariant &value, int type)
+{
+    switch (type) {
+    case QMetaType::Int:
+        return valueData<int>(value);
+    case QMetaType::UInt:
+        return valueData<uint>(value);
+    default:
+        return valueData<qlonglong>(value);
+    }
 }
 
-FilterModel::FilterData::FilterData(const QString &role, const QString &property, const QVariant &value, FilterModel::Comparator comparator, bool negate)
+double realData(const QVariant &value, int type)
+{
+    switch (type) {
+    case QMetaType::Double:
+        return valueData<double>(value);
+    case QMetaType::Float:
+        return valueData<float>(value);
+    default:
+        return integerData(value, type);
+    }
+}
+
+// Strings compared generically by a case insensitive filter are compared in case folded form
+QVariant foldedValue(const QVariant &value, Qt::CaseSensitivity caseSensitivity)
+{
+    if (caseSensitivity == Qt::CaseInsensitive && value.userType() == QMetaType::QString) {
+        return QVariant(value.toString().toCaseFolded());
+    }
+    return value;
+}
+
+// Returns true if the real value is exactly equal to a 64-bit integer value
+bool integralValue(double value, qint64 *integer)
+{
+    if (value >= -9223372036854775808.0 && value < 9223372036854775808.0 && value == std::floor(value)) {
+        *integer = static_cast<qint64>(value);
+        return true;
+    }
+    return false;
+}
+
+template<typename T>
+int compareOrder(const T &lhs, const T &rhs)
+{
+    return lhs < rhs ? -1 : (rhs < lhs ? 1 : 0);
+}
+
+bool variantLessThan(const QVariant &lhs, const QVariant &rhs)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    return QVariant::compare(lhs, rhs) < 0;
+#else
+    return lhs < rhs;
+#endif
+}
+
+// Bit sets containing a bit for each source item
+int wordCount(int bitCount)
+{
+    return (bitCount + 63) / 64;
+}
+
+bool testBit(const std::vector<quint64> &bits, int index)
+{
+    return (bits[index >> 6] >> (index & 63)) & 1;
+}
+
+void setBit(std::vector<quint64> *bits, int index, bool value)
+{
+    const quint64 mask(quint64(1) << (index & 63));
+    if (value) {
+        (*bits)[index >> 6] |= mask;
+    } else {
+        (*bits)[index >> 6] &= ~mask;
+    }
+}
+
+// Returns the 64 bits starting at index; bits outside the set are zero
+quint64 readBits(const std::vector<quint64> &bits, int index)
+{
+    if (index < 0) {
+        return (index > -64 && !bits.empty()) ? (bits[0] << -index) : 0;
+    }
+
+    const size_t word(index >> 6);
+    const int offset(index & 63);
+    quint64 rv = word < bits.size() ? (bits[word] >> offset) : 0;
+    if (offset && word + 1 < bits.size()) {
+        rv |= bits[word + 1] << (64 - offset);
+    }
+    return rv;
+}
+
+// Replaces the count bits (at most 64) starting at index with the low bits of value
+void writeBits(std::vector<quint64> *bits, int index, quint64 value, int count)
+{
+    const quint64 mask(count == 64 ? ~quint64(0) : (quint64(1) << count) - 1);
+    const int word(index >> 6);
+    const int offset(index & 63);
+
+    value &= mask;
+    (*bits)[word] = ((*bits)[word] & ~(mask << offset)) | (value << offset);
+    if (offset + count > 64) {
+        (*bits)[word + 1] = ((*bits)[word + 1] & ~(mask >> (64 - offset))) | (value >> (64 - offset));
+    }
+}
+
+void clearBits(std::vector<quint64> *bits, int index, int count)
+{
+    for (int i = 0; i < count; i += 64) {
+        writeBits(bits, index + i, 0, qMin(64, count - i));
+    }
+}
+
+void insertBits(std::vector<quint64> *bits, int bitCount, int index, int count)
+{
+    const int words(wordCount(bitCount + count));
+    bits->resize(words, 0);
+
+    // Shift the following bits upward a word at a time, from the end; each word only
+    // reads from itself and the words below it
+    const int first(index >> 6);
+    const quint64 retained((quint64(1) << (index & 63)) - 1);
+    for (int word = words - 1; word >= first; --word) {
+        quint64 value(readBits(*bits, (word << 6) - count));
+        if (word == first) {
+            value = ((*bits)[word] & retained) | (value & ~retained);
+        }
+        (*bits)[word] = value;
+    }
+
+    clearBits(bits, index, count);
+}
+
+void removeBits(std::vector<quint64> *bits, int bitCount, int index, int count)
+{
+    // Shift the following bits downward a word at a time; each word only reads from
+    // itself and the words above it
+    const int words(wordCount(bitCount));
+    const int first(index >> 6);
+    const quint64 retained((quint64(1) << (index & 63)) - 1);
+    for (int word = first; word < words; ++word) {
+        quint64 value(readBits(*bits, (word << 6) + count));
+        if (word == first) {
+            value = ((*bits)[word] & retained) | (value & ~retained);
+        }
+        (*bits)[word] = value;
+    }
+
+    bits->resize(wordCount(bitCount - count));
+}
+
+void moveBits(std::vector<quint64> *bits, int bitCount, int index, int count, int destination)
+{
+    std::vector<quint64> moved(wordCount(count));
+    for (int i = 0; i < count; i += 64) {
+        moved[i >> 6] = readBits(*bits, index + i);
+    }
+    removeBits(bits, bitCount, index, count);
+    insertBits(bits, bitCount - count, destination, count);
+    for (int i = 0; i < count; i += 64) {
+        writeBits(bits, destination + i, moved[i >> 6], qMin(64, count - i));
+    }
+}
+
+}
+
+FilterModel::FilterData::FilterData(const QString &role, const QString &property, const QVariant &value, FilterModel::Comparator comparator, bool negate, Qt::CaseSensitivity caseSensitivity)
     : role_(-1)
     , initialized_(false)
     , negate_(negate)
@@ -91,40 +319,120 @@ FilterModel::FilterData::FilterData(const QString &role, const QString &property
     , value_(value)
     , roleName_(role.toUtf8())
     , propertyName_(property.toUtf8())
+    , valueType_(GenericValue)
+    , caseSensitivity_(caseSensitivity)
+    , comparison_(GenericValue)
+    , sourceType_(QMetaType::UnknownType)
+    , group_(false)
+    , requirement_(FilterModel::PassAllFilters)
+    , cost_(comparatorCost(comparator))
 {
+    if (comparator_ == FilterModel::In) {
+        foreach (const QVariant &element, value.toList()) {
+            const ValueType type(valueType(element.userType()));
+            if (type == IntegerValue) {
+                integerSet_.insert(element.toLongLong());
+            } else if (type == RealValue) {
+                realSet_.insert(element.toDouble());
+            } else if (type == StringValue) {
+                stringSet_.insert(caseSensitivity_ == Qt::CaseInsensitive ? element.toString().toCaseFolded() : element.toString());
+            } else {
+                values_.append(element);
+            }
+        }
+    } else if (comparator_ == FilterModel::Between) {
+        // The range includes the lower bound and excludes the upper bound
+        values_ = value.toList();
+        if (values_.count() == 2) {
+            const ValueType lowerType(typedValue(values_.at(0), &typedValue_));
+            const ValueType upperType(typedValue(values_.at(1), &typedLimit_));
+            if (lowerType == upperType) {
+                valueType_ = lowerType;
+            } else if ((lowerType == IntegerValue || lowerType == RealValue) && (upperType == IntegerValue || upperType == RealValue)) {
+                valueType_ = RealValue;
+            }
+        }
+    } else {
+        valueType_ = typedValue(value, &typedValue_);
+    }
+}
+
+FilterModel::FilterData::FilterData(FilterModel::FilterRequirement requirement, const QList<FilterData> &children)
+    : role_(-1)
+    , initialized_(false)
+    , negate_(false)
+    , comparator_(FilterModel::None)
+    , valueType_(GenericValue)
+    , caseSensitivity_(Qt::CaseSensitive)
+    , comparison_(GenericValue)
+    , sourceType_(QMetaType::UnknownType)
+    , group_(true)
+    , requirement_(requirement)
+    , children_(children)
+    , order_(evaluationOrder(children_))
+    , cost_(0)
+{
+    for (const FilterData &child : children_) {
+        cost_ += child.cost_;
+    }
 }
 
 bool FilterModel::FilterData::operator==(const FilterData &other) const
 {
-    return (roleName_ == other.roleName_ && propertyName_ == other.propertyName_ && value_ == other.value_ && comparator_ == other.comparator_ && negate_ == other.negate_);
+    return (roleName_ == other.roleName_ && propertyName_ == other.propertyName_ && value_ == other.value_ && comparator_ == other.comparator_ && negate_ == other.negate_
+            && caseSensitivity_ == other.caseSensitivity_ && group_ == other.group_ && requirement_ == other.requirement_ && children_ == other.children_);
 }
 
+FilterModel::FilterData::ValueType FilterModel::FilterData::valueType(int metaType)
+{
+    switch (metaType) {
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+        return IntegerValue;
+    case QMetaType::Double:
+    case QMetaType::Float:
+        return RealValue;
+    case QMetaType::QDateTime:
+        return DateTimeValue;
+    case QMetaType::QString:
+        return StringValue;
+    default:
+        return GenericValue;
+    }
+}
+
+FilterModel::FilterData::ValueType FilterModel::FilterData::typedValue(const QVariant &value, TypedValue *typed)
+{
+    const ValueType rv(valueType(value.userType()));
+    if (rv == IntegerValue || rv == RealValue) {
+        typed->integer_ = value.toLongLong();
+        typed->real_ = value.toDouble();
+    } else if (rv == DateTimeValue) {
+        const QDateTime dateTime(value.toDateTime());
+        if (!dateTime.isValid()) {
+            return GenericValue;
+        }
+        typed->integer_ = dateTime.toMSecsSinceEpoch();
+    } else if (rv == StringValue) {
+        typed->string_ = value.toString();
+    }
+    return rv;
+}
 
 FilterModel::FilterModel(QObject *parent)
     : BaseFilterModel(parent)
     , requirement_(PassAllFilters)
+    , sourceCount_(0)
+    , includedValid_(false)
 {
 }
 
 void FilterModel::setFilters(const QVariantList &filters)
 {
     QList<FilterData> newFilters;
-
     foreach (const QVariant &var, filters) {
-        const QVariantMap &filter = qvariant_cast<QVariantMap>(var);
-
-        if (!filter.contains("comparator") || !filter.contains("value") || (!filter.contains("property") && !filter.contains("role"))) {
-            qWarning() << "Invalid filter specified:" << filter;
-        } else if (filter.contains("property") && filter.contains("role")) {
-            qWarning() << "Invalid filter - cannot use both property and role:" << filter;
-        } else {
-            const QString role(filter["role"].value<QString>());
-            const QString property(filter["property"].value<QString>());
-            const QString comparator(filter["comparator"].value<QString>());
-            const QVariant &value(filter["value"]);
-            const QPair<FilterModel::Comparator, bool> type(comparatorType(comparator));
-            newFilters.append(FilterData(role, property, value, type.first, type.second));
-        }
+        parseFilter(var, &newFilters);
     }
 
     bool changed(newFilters.count() != filters_.count());
@@ -138,10 +446,29 @@ void FilterModel::setFilters(const QVariantList &filters)
         }
     }
     if (changed) {
+        // Retain the results of any filter that is unchanged, wherever it appears
+        const QList<FilterData> &oldFilters(filters_);
+        std::vector<const FilterData *> retained;
+        forEachLeaf(oldFilters, [&retained](const FilterData &filter) { retained.push_back(&filter); });
+
+        const int words(wordCount(sourceCount_));
+        forEachLeaf(newFilters, [&retained, words](FilterData &filter) {
+            auto it = std::find_if(retained.cbegin(), retained.cend(), [&filter](const FilterData *other) { return *other == filter; });
+            if (it != retained.cend()) {
+                filter.passed_ = (*it)->passed_;
+                filter.known_ = (*it)->known_;
+            } else {
+                filter.passed_.assign(words, 0);
+                filter.known_.assign(words, 0);
+            }
+        });
+
         filters_ = newFilters;
+        filterOrder_ = evaluationOrder(filters_);
+        includedValid_ = false;
 
         if (populated_ && model_) {
-            populateModel();
+            resetMapping();
         }
 
         emit filtersChanged();
@@ -154,14 +481,7 @@ QVariantList FilterModel::filters() const
 
     QList<FilterData>::const_iterator it = filters_.constBegin(), end = filters_.constEnd();
     for ( ; it != end; ++it) {
-        QVariantMap filter;
-        if (!it->roleName_.isEmpty())
-            filter.insert("role", QString::fromUtf8(it->roleName_));
-        if (!it->propertyName_.isEmpty())
-            filter.insert("property", QString::fromUtf8(it->propertyName_));
-        filter.insert("comparator", comparatorName(qMakePair(it->comparator_, it->negate_)));
-        filter.insert("value", it->value_);
-        rv.append(filter);
+        rv.append(filterDescription(*it));
     }
 
     return rv;
@@ -171,9 +491,10 @@ void FilterModel::setFilterRequirement(FilterRequirement requirement)
 {
     if (requirement != requirement_) {
         requirement_ = requirement;
+        includedValid_ = false;
 
         if (populated_ && model_) {
-            populateModel();
+            resetMapping();
         }
 
         emit filterRequirementChanged();
@@ -193,10 +514,14 @@ bool FilterModel::filtered() const
 bool FilterModel::includeItem(int sourceRow) const
 {
     if (!filters_.isEmpty()) {
+        if (includedValid_) {
+            return testBit(included_, sourceRow);
+        }
+
         const bool passAll(requirement_ == PassAllFilters);
 
-        foreach (const FilterData &filter, filters_) {
-            const bool passed = passesFilter(sourceRow, filter);
+        for (int index : filterOrder_) {
+            const bool passed = filterResult(sourceRow, filters_.at(index));
             if (passAll && !passed) {
                 return false;
             } else if (!passAll && passed) {
@@ -210,6 +535,103 @@ bool FilterModel::includeItem(int sourceRow) const
     return true;
 }
 
+void FilterModel::evaluateItems() const
+{
+    if (includedValid_ || filters_.isEmpty()) {
+        return;
+    }
+
+    std::vector<const FilterData *> filters;
+    for (int index : filterOrder_) {
+        filters.push_back(&filters_.at(index));
+    }
+
+    std::vector<quint64> mask(wordCount(sourceCount_), ~quint64(0));
+    if (sourceCount_ & 63) {
+        mask.back() = (quint64(1) << (sourceCount_ & 63)) - 1;
+    }
+
+    included_ = evaluateGroup(filters, requirement_, mask);
+    includedValid_ = true;
+}
+
+std::vector<quint64> FilterModel::evaluateFilter(const FilterData &filter, const std::vector<quint64> &mask) const
+{
+    if (filter.group_) {
+        std::vector<const FilterData *> children;
+        for (int index : filter.order_) {
+            children.push_back(&filter.children_.at(index));
+        }
+        return evaluateGroup(children, filter.requirement_, mask);
+    }
+
+    // Evaluate the filter for each masked item whose result is not yet known
+    std::vector<quint64> rv(mask.size());
+    for (size_t word = 0; word < mask.size(); ++word) {
+        const quint64 unknown(mask[word] & ~filter.known_[word]);
+        if (unknown) {
+            for (int bit = 0; bit < 64; ++bit) {
+                if ((unknown >> bit) & 1) {
+                    const int sourceRow(word * 64 + bit);
+                    setBit(&filter.passed_, sourceRow, passesFilter(sourceRow, filter));
+                    setBit(&filter.known_, sourceRow, true);
+                }
+            }
+        }
+        rv[word] = filter.passed_[word] & mask[word];
+    }
+    return rv;
+}
+
+std::vector<quint64> FilterModel::evaluateGroup(const std::vector<const FilterData *> &filters, FilterRequirement requirement, const std::vector<quint64> &mask) const
+{
+    // Each filter is evaluated only for the items not already decided by the filters before it
+    const bool passAll(requirement == PassAllFilters);
+    std::vector<quint64> rv(passAll ? mask : std::vector<quint64>(mask.size(), 0));
+    std::vector<quint64> pending(mask);
+
+    for (const FilterData *filter : filters) {
+        if (std::find_if(pending.cbegin(), pending.cend(), [](quint64 word) { return word != 0; }) == pending.cend()) {
+            break;
+        }
+
+        const std::vector<quint64> passed(evaluateFilter(*filter, pending));
+        for (size_t word = 0; word < pending.size(); ++word) {
+            if (passAll) {
+                rv[word] &= passed[word] | ~pending[word];
+                pending[word] &= passed[word];
+            } else {
+                rv[word] |= passed[word];
+                pending[word] &= ~passed[word];
+            }
+        }
+    }
+
+    return rv;
+}
+
+bool FilterModel::filterResult(int sourceRow, const FilterData &filter) const
+{
+    if (filter.group_) {
+        const bool passAll(filter.requirement_ == PassAllFilters);
+        for (int index : filter.order_) {
+            const bool passed = filterResult(sourceRow, filter.children_.at(index));
+            if (passAll && !passed) {
+                return false;
+            } else if (!passAll && passed) {
+                return true;
+            }
+        }
+        return passAll;
+    }
+
+    if (!testBit(filter.known_, sourceRow)) {
+        setBit(&filter.passed_, sourceRow, passesFilter(sourceRow, filter));
+        setBit(&filter.known_, sourceRow, true);
+    }
+    return testBit(filter.passed_, sourceRow);
+}
+
 bool FilterModel::passesFilter(int sourceRow, const FilterData &filter) const
 {
     if (filter.comparator_ == FilterModel::None)
@@ -217,35 +639,66 @@ bool FilterModel::passesFilter(int sourceRow, const FilterData &filter) const
 
     const QVariant value(itemValue(sourceRow, filter));
 
+    if (filter.comparator_ == FilterModel::Equal || filter.comparator_ == FilterModel::LessThan || filter.comparator_ == FilterModel::LessThanEqual) {
+        int order;
+        if (compareValue(value, filter, filter.typedValue_, &order)) {
+            const bool passed(filter.comparator_ == FilterModel::Equal ? order == 0 : (filter.comparator_ == FilterModel::LessThan ? order < 0 : order <= 0));
+            return passed != filter.negate_;
+        }
+    } else if (filter.comparator_ == FilterModel::In) {
+        return containsValue(value, filter) != filter.negate_;
+    } else if (filter.comparator_ == FilterModel::Between) {
+        if (filter.values_.count() != 2) {
+            return false;
+        }
+
+        bool inRange;
+        int lower, upper;
+        if (compareValue(value, filter, filter.typedValue_, &lower) && compareValue(value, filter, filter.typedLimit_, &upper)) {
+            inRange = lower >= 0 && upper < 0;
+        } else {
+            const QVariant item(foldedValue(value, filter.caseSensitivity_));
+            inRange = !variantLessThan(item, foldedValue(filter.values_.at(0), filter.caseSensitivity_))
+                      && variantLessThan(item, foldedValue(filter.values_.at(1), filter.caseSensitivity_));
+        }
+        return inRange != filter.negate_;
+    }
+
     QRegularExpression re;
     if (filter.comparator_ == FilterModel::HasMatch || filter.comparator_ == FilterModel::ElementHasMatch) {
         re.setPattern(filter.value_.toString());
+        if (filter.caseSensitivity_ == Qt::CaseInsensitive) {
+            re.setPatternOptions(QRegularExpression::CaseInsensitiveOption);
+        }
     }
 
+    const QVariant item(foldedValue(value, filter.caseSensitivity_));
+    const QVariant filterValue(foldedValue(filter.value_, filter.caseSensitivity_));
+
     if (filter.comparator_ == FilterModel::Equal) {
-        if ((value == filter.value_) == filter.negate_)
+        if ((item == filterValue) == filter.negate_)
             return false;
     } else if (filter.comparator_ == FilterModel::LessThan) {
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-        if ((QVariant::compare(value, filter.value_) < 0) == filter.negate_)
+        if ((QVariant::compare(item, filterValue) < 0) == filter.negate_)
 #else
-        if ((value < filter.value_) == filter.negate_)
+        if ((item < filterValue) == filter.negate_)
 #endif
             return false;
     } else if (filter.comparator_ == FilterModel::LessThanEqual) {
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-        if ((QVariant::compare(value, filter.value_) <= 0) == filter.negate_)
+        if ((QVariant::compare(item, filterValue) <= 0) == filter.negate_)
 #else
-        if ((value <= filter.value_) == filter.negate_)
+        if ((item <= filterValue) == filter.negate_)
 #endif
             return false;
     } else if (filter.comparator_ == FilterModel::HasMatch) {
         if (re.match(value.toString()).hasMatch() == filter.negate_)
             return false;
     } else {
-        auto testElement = [&filter, &re](const QVariant &element) -> bool {
+        auto testElement = [&filter, &filterValue, &re](const QVariant &element) -> bool {
             if (filter.comparator_ == FilterModel::ElementEqual) {
-                if (element == filter.value_)
+                if (foldedValue(element, filter.caseSensitivity_) == filterValue)
                     return true;
             } else if (filter.comparator_ == FilterModel::ElementHasMatch) {
                 if (re.match(element.toString()).hasMatch())
@@ -297,6 +750,92 @@ bool FilterModel::passesFilter(int sourceRow, const FilterData &filter) const
     return true;
 }
 
+bool FilterModel::compareValue(const QVariant &value, const FilterData &filter, const FilterData::TypedValue &bound, int *order) const
+{
+    const int type(value.userType());
+
+    if (filter.sourceType_ == QMetaType::UnknownType) {
+        // Choose the comparison from the types of the filter value and the first source value
+        const FilterData::ValueType sourceType(FilterData::valueType(type));
+        filter.sourceType_ = type;
+        if (sourceType == filter.valueType_) {
+            filter.comparison_ = sourceType;
+        } else if ((sourceType == FilterData::IntegerValue || sourceType == FilterData::RealValue)
+                   && (filter.valueType_ == FilterData::IntegerValue || filter.valueType_ == FilterData::RealValue)) {
+            filter.comparison_ = FilterData::RealValue;
+        } else {
+            filter.comparison_ = FilterData::GenericValue;
+        }
+    }
+
+    // Values of any other type use the generic comparison
+    if (type != filter.sourceType_) {
+        return false;
+    }
+
+    switch (filter.comparison_) {
+    case FilterData::IntegerValue:
+        *order = compareOrder(integerData(value, type), bound.integer_);
+        return true;
+    case FilterData::RealValue: {
+        const double item(realData(value, type));
+        if (qIsNaN(item) || qIsNaN(bound.real_)) {
+            return false;
+        }
+        *order = compareOrder(item, bound.real_);
+        return true;
+    }
+    case FilterData::DateTimeValue: {
+        const QDateTime &item(valueData<QDateTime>(value));
+        if (!item.isValid()) {
+            return false;
+        }
+        *order = compareOrder(item.toMSecsSinceEpoch(), bound.integer_);
+        return true;
+    }
+    case FilterData::StringValue:
+        *order = QString::compare(valueData<QString>(value), bound.string_, filter.caseSensitivity_);
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool FilterModel::containsValue(const QVariant &value, const FilterData &filter) const
+{
+    const int type(value.userType());
+    const FilterData::ValueType valueType(FilterData::valueType(type));
+
+    // Integers are not compared as reals, which cannot represent all 64-bit values exactly
+    if (valueType == FilterData::IntegerValue) {
+        const qint64 item(integerData(value, type));
+        if (filter.integerSet_.contains(item)) {
+            return true;
+        }
+        qint64 integer;
+        if (!filter.realSet_.isEmpty() && integralValue(static_cast<double>(item), &integer) && integer == item && filter.realSet_.contains(static_cast<double>(item))) {
+            return true;
+        }
+    } else if (valueType == FilterData::RealValue) {
+        const double item(realData(value, type));
+        if (filter.realSet_.contains(item)) {
+            return true;
+        }
+        qint64 integer;
+        if (!filter.integerSet_.isEmpty() && integralValue(item, &integer) && filter.integerSet_.contains(integer)) {
+            return true;
+        }
+    } else if (valueType == FilterData::StringValue) {
+        const QString &item(valueData<QString>(value));
+        if (filter.stringSet_.contains(filter.caseSensitivity_ == Qt::CaseInsensitive ? item.toCaseFolded() : item)) {
+            return true;
+        }
+    }
+
+    // Elements of other types are compared individually
+    return filter.values_.contains(value);
+}
+
 QVariant FilterModel::itemValue(int sourceRow, const FilterData &filter) const
 {
     if (filter.role_ != -1) {
@@ -320,3 +859,110 @@ QVariant FilterModel::itemValue(int sourceRow, const FilterData &filter) const
     return QVariant();
 }
 
+void FilterModel::parseFilter(const QVariant &var, QList<FilterData> *filters)
+{
+    const QVariantMap &filter = qvariant_cast<QVariantMap>(var);
+
+    if (filter.contains("any") || filter.contains("all")) {
+        if (filter.count() != 1) {
+            qWarning() << "Invalid filter group - must contain only one of any or all:" << filter;
+        } else {
+            const bool any(filter.contains("any"));
+            QList<FilterData> children;
+            foreach (const QVariant &child, filter[any ? "any" : "all"].toList()) {
+                parseFilter(child, &children);
+            }
+            filters->append(FilterData(any ? PassAnyFilter : PassAllFilters, children));
+        }
+    } else if (!filter.contains("comparator") || !filter.contains("value") || (!filter.contains("property") && !filter.contains("role"))) {
+        qWarning() << "Invalid filter specified:" << filter;
+    } else if (filter.contains("property") && filter.contains("role")) {
+        qWarning() << "Invalid filter - cannot use both property and role:" << filter;
+    } else {
+        const QString role(filter["role"].value<QString>());
+        const QString property(filter["property"].value<QString>());
+        const QString comparator(filter["comparator"].value<QString>());
+        const QVariant &value(filter["value"]);
+        const Qt::CaseSensitivity caseSensitivity(static_cast<Qt::CaseSensitivity>(filter.value("caseSensitivity", int(Qt::CaseSensitive)).toInt()));
+        const QPair<FilterModel::Comparator, bool> type(comparatorType(comparator));
+        if (type.first == Between && value.toList().count() != 2) {
+            qWarning() << "Invalid filter - between requires a list of two values:" << filter;
+        } else {
+            filters->append(FilterData(role, property, value, type.first, type.second, caseSensitivity));
+        }
+    }
+}
+
+QVariantMap FilterModel::filterDescription(const FilterData &filter)
+{
+    QVariantMap rv;
+
+    if (filter.group_) {
+        QVariantList children;
+        for (const FilterData &child : filter.children_) {
+            children.append(filterDescription(child));
+        }
+        rv.insert(filter.requirement_ == PassAnyFilter ? "any" : "all", children);
+    } else {
+        if (!filter.roleName_.isEmpty())
+            rv.insert("role", QString::fromUtf8(filter.roleName_));
+        if (!filter.propertyName_.isEmpty())
+            rv.insert("property", QString::fromUtf8(filter.propertyName_));
+        rv.insert("comparator", comparatorName(qMakePair(filter.comparator_, filter.negate_)));
+        rv.insert("value", filter.value_);
+        if (filter.caseSensitivity_ != Qt::CaseSensitive)
+            rv.insert("caseSensitivity", int(filter.caseSensitivity_));
+    }
+
+    return rv;
+}
+
+void FilterModel::sourceItemsInserted(int insertIndex, int insertCount)
+{
+    forEachLeaf(filters_, [this, insertIndex, insertCount](FilterData &filter) {
+        insertBits(&filter.passed_, sourceCount_, insertIndex, insertCount);
+        insertBits(&filter.known_, sourceCount_, insertIndex, insertCount);
+    });
+    sourceCount_ += insertCount;
+    includedValid_ = false;
+}
+
+void FilterModel::sourceItemsMoved(int moveIndex, int moveCount, int insertIndex)
+{
+    // The insertion index is specified relative to the items before the move
+    const int destination(insertIndex > moveIndex ? insertIndex - moveCount : insertIndex);
+    forEachLeaf(filters_, [this, moveIndex, moveCount, destination](FilterData &filter) {
+        moveBits(&filter.passed_, sourceCount_, moveIndex, moveCount, destination);
+        moveBits(&filter.known_, sourceCount_, moveIndex, moveCount, destination);
+    });
+    includedValid_ = false;
+}
+
+void FilterModel::sourceItemsRemoved(int removeIndex, int removeCount)
+{
+    forEachLeaf(filters_, [this, removeIndex, removeCount](FilterData &filter) {
+        removeBits(&filter.passed_, sourceCount_, removeIndex, removeCount);
+        removeBits(&filter.known_, sourceCount_, removeIndex, removeCount);
+    });
+    sourceCount_ -= removeCount;
+    includedValid_ = false;
+}
+
+void FilterModel::sourceItemsChanged(int changeIndex, int changeCount)
+{
+    forEachLeaf(filters_, [changeIndex, changeCount](FilterData &filter) {
+        clearBits(&filter.known_, changeIndex, changeCount);
+    });
+    includedValid_ = false;
+}
+
+void FilterModel::sourceItemsCleared()
+{
+    forEachLeaf(filters_, [](FilterData &filter) {
+        filter.passed_.clear();
+        filter.known_.clear();
+        filter.sourceType_ = QMetaType::UnknownType;
+    });
+    sourceCount_ = 0;
+    includedValid_ = false;
+}
@@ -38,6 +38,9 @@
 
 #include <QList>
 #include <QMetaMethod>
+#include <QSet>
+
+#include <vector>
 
 class NEMO_QML_PLUGIN_MODELS_EXPORT FilterModel : public BaseFilterModel
 {
@@ -59,6 +62,8 @@ public:
         HasMatch,
         ElementEqual,
         ElementHasMatch,
+        In,
+        Between,
     };
 
     explicit FilterModel(QObject *parent = 0);
@@ -84,20 +89,90 @@ protected:
         QByteArray roleName_;
         QByteArray propertyName_;
 
-        FilterData(const QString &role, const QString &property, const QVariant &value, FilterModel::Comparator comparator, bool negate);
+        // The filter value in the form used for typed comparison with source values
+        enum ValueType {
+            GenericValue,
+            IntegerValue,
+            RealValue,
+            DateTimeValue,
+            StringValue,
+        };
+        struct TypedValue {
+            qint64 integer_;
+            double real_;
+            QString string_;
+
+            TypedValue() : integer_(0), real_(0) {}
+        };
+        ValueType valueType_;
+        TypedValue typedValue_;
+        TypedValue typedLimit_;
+        Qt::CaseSensitivity caseSensitivity_;
+
+        // The elements of a list filter value, hashed by type where possible
+        QSet<qint64> integerSet_;
+        QSet<double> realSet_;
+        QSet<QString> stringSet_;
+        QVariantList values_;
+
+        // The comparison chosen for the type of the first source value examined
+        mutable ValueType comparison_;
+        mutable int sourceType_;
+
+        // For a group, the filters combined according to the group requirement
+        bool group_;
+        FilterModel::FilterRequirement requirement_;
+        QList<FilterData> children_;
+
+        // The indices of the children in evaluation order, cheapest first
+        std::vector<int> order_;
+        int cost_;
+
+        // The result of this filter for each source item, where known
+        mutable std::vector<quint64> passed_;
+        mutable std::vector<quint64> known_;
+
+        FilterData(const QString &role, const QString &property, const QVariant &value, FilterModel::Comparator comparator, bool negate, Qt::CaseSensitivity caseSensitivity = Qt::CaseSensitive);
+        FilterData(FilterModel::FilterRequirement requirement, const QList<FilterData> &children);
 
         bool operator==(const FilterData &other) const;
         bool operator!=(const FilterData &other) const { return !operator==(other); }
+
+        static ValueType valueType(int metaType);
+        static ValueType typedValue(const QVariant &value, TypedValue *typed);
     };
 
     bool filtered() const override;
     bool includeItem(int sourceRow) const override;
+    void evaluateItems() const override;
 
+    bool filterResult(int sourceRow, const FilterData &filter) const;
+    std::vector<quint64> evaluateFilter(const FilterData &filter, const std::vector<quint64> &mask) const;
+    std::vector<quint64> evaluateGroup(const std::vector<const FilterData *> &filters, FilterRequirement requirement, const std::vector<quint64> &mask) const;
     bool passesFilter(int sourceRow, const FilterData &filter) const;
+    bool compareValue(const QVariant &value, const FilterData &filter, const FilterData::TypedValue &bound, int *order) const;
+    bool containsValue(const QVariant &value, const FilterData &filter) const;
     QVariant itemValue(int sourceRow, const FilterData &filter) const;
 
+    static void parseFilter(const QVariant &var, QList<FilterData> *filters);
+    static QVariantMap filterDescription(const FilterData &filter);
+
+    void sourceItemsInserted(int insertIndex, int insertCount) override;
+    void sourceItemsMoved(int moveIndex, int moveCount, int insertIndex) override;
+    void sourceItemsRemoved(int removeIndex, int removeCount) override;
+    void sourceItemsChanged(int changeIndex, int changeCount) override;
+    void sourceItemsCleared() override;
+
     QList<FilterData> filters_;
     FilterRequirement requirement_;
+
+    // The indices of the filters in evaluation order, cheapest first
+    std::vector<int> filterOrder_;
+
+    // The combination of all filter results, when every result is known
+    int sourceCount_;
+    mutable std::vector<quint64> included_;
+    mutable bool includedValid_;
 };
 
 #endif // FILTERMODEL_H
@@ -17,7 +17,10 @@ SOURCES += \
     filtermodel.cpp \
     objectlistmodel.cpp \
     searchmodel.cpp \
-    sortfiltermodel.cpp
+    searchtokencache.cpp \
+    searchtokenpool.cpp \
+    sortfiltermodel.cpp \
+    sourcedata.cpp
 
 HEADERS += \
     basefiltermodel.h \
@@ -25,7 +28,10 @@ HEADERS += \
     filtermodel.h \
     objectlistmodel.h \
     searchmodel.h \
-    sortfiltermodel.h
+    searchtokencache.h \
+    searchtokenpool.h \
+    sortfiltermodel.h \
+    sourcedata.h
 
 DEFINES += BUILD_NEMO_QML_PLUGIN_MODELS_LIB
 
@@ -37,6 +37,8 @@
 #include <QMetaProperty>
 #include <QDebug>
 
+#include <algorithm>
+
 namespace {
 
 enum {
@@ -45,42 +47,198 @@ enum {
     FirstAutomaticRole,
 };
 
-QHash<int, QByteArray> rolesFromItem(QObject *item)
+// Presents the item vector with the list interface used by synchronizeList
+struct ItemList
+{
+    typedef QObject * const &const_reference;
+
+    const std::vector<QObject *> &items;
+
+    int count() const { return items.size(); }
+    const_reference at(int index) const { return items[index]; }
+};
+
+// The index of each named property, for each type of item; -1 where there is no such static property
+typedef QHash<const QMetaObject *, QHash<QString, int> > PropertyIndices;
+
+// Returns the value converted to the type of the property, so that it compares equal to an equal property value
+QVariant propertyValue(const QMetaProperty &property, const QVariant &value)
+{
+    const int type(property.userType());
+    if (type == QMetaType::QVariant || value.userType() == type)
+        return value;
+
+    QVariant rv(value);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    if (rv.convert(property.metaType()))
+        return rv;
+#else
+    if (rv.convert(type))
+        return rv;
+#endif
+    return value;
+}
+
+bool writeProperties(QObject *item, const QVariantMap &values, PropertyIndices *indices, QStringList *changed)
+{
+    bool rv = false;
+
+    const QMetaObject *mo(item->metaObject());
+    QHash<QString, int> &propertyIndices((*indices)[mo]);
+
+    for (QVariantMap::const_iterator it = values.cbegin(), end = values.cend(); it != end; ++it) {
+        QHash<QString, int>::const_iterator pit = propertyIndices.constFind(it.key());
+        if (pit == propertyIndices.constEnd()) {
+            pit = propertyIndices.insert(it.key(), mo->indexOfProperty(it.key().toUtf8().constData()));
+        }
+
+        if (*pit == -1) {
+            const QByteArray roleName(it.key().toUtf8());
+            const QVariant current(item->property(roleName));
+            if (current.isValid()) {
+                // A dynamic property
+                if (current != it.value()) {
+                    item->setProperty(roleName, it.value());
+                    if (changed) {
+                        changed->append(it.key());
+                    }
+                    rv = true;
+                }
+                continue;
+            }
+        } else {
+            const QMetaProperty property(mo->property(*pit));
+            if (property.isWritable()) {
+                // The property's own setter emits any change notification
+                const QVariant value(propertyValue(property, it.value()));
+                if (property.read(item) != value) {
+                    property.write(item, value);
+                    if (changed) {
+                        changed->append(it.key());
+                    }
+                    rv = true;
+                }
+                continue;
+            }
+        }
+
+        qWarning() << "Unable to update object property:" << it.key();
+    }
+
+    return rv;
+}
+
+// The property values of an object to be transferred to the item it replaces
+QVariantMap transferredProperties(QObject *object, const QByteArray &key)
+{
+    QVariantMap rv;
+
+    const QMetaObject *mo(object->metaObject());
+    for (int i = 0, n = mo->propertyCount(); i < n; ++i) {
+        const QMetaProperty prop(mo->property(i));
+        if (prop.isReadable() && prop.isWritable() && prop.isStored() && key != prop.name()) {
+            rv.insert(QString::fromUtf8(prop.name()), prop.read(object));
+        }
+    }
+    for (const auto name : object->dynamicPropertyNames()) {
+        if (name != key) {
+            rv.insert(QString::fromUtf8(name), object->property(name));
+        }
+    }
+
+    return rv;
+}
+
+QHash<int, QByteArray> rolesFromItem(QObject *item, std::vector<QMetaProperty> *properties)
 {
     QHash<int, QByteArray> rv;
 
     int role(FirstAutomaticRole);
+    properties->clear();
 
     const QMetaObject *mo(item->metaObject());
     for (int i = 0, n = mo->propertyCount(); i < n; ++i) {
         const QMetaProperty prop(mo->property(i));
         if (prop.isReadable()) {
             rv.insert(role, prop.name());
+            properties->push_back(prop);
             ++role;
         }
     }
     for (const auto name : item->dynamicPropertyNames()) {
+        // Dynamic properties can only be read by name
         rv.insert(role, name);
+        properties->push_back(QMetaProperty());
         ++role;
     }
 
     return rv;
 }
 
+// The slot connected to the notify signals of tracked items
+const QMetaMethod &itemPropertyChangedMethod()
+{
+    static const QMetaMethod method(ObjectListModel::staticMetaObject.method(ObjectListModel::staticMetaObject.indexOfMethod("itemPropertyChanged()")));
+    return method;
+}
+
 }
 
 ObjectListModel::ObjectListModel(QObject *parent, bool automaticRoles, bool populated)
     : QAbstractListModel(parent)
     , automaticRoles_(automaticRoles)
     , populated_(populated)
+    , notifyChanges_(false)
+    , batchChanges_(false)
+    , roleMetaObject_(0)
+    , deleting_(false)
 {
+    // Pending changes are reported once per event loop iteration
+    changeTimer_.setSingleShot(true);
+    changeTimer_.setInterval(0);
+    connect(&changeTimer_, &QTimer::timeout, this, &ObjectListModel::reportChanges);
 }
 
 void ObjectListModel::setAutomaticRoles(bool enabled)
 {
     if (enabled != automaticRoles_) {
+        // The role names change for any existing items
+        const bool reset(!items_.empty());
+        if (reset) {
+            beginResetModel();
+        }
+
+        for (QObject *item : items_) {
+            if (!isDestroyed(item)) {
+                untrackItem(item);
+            }
+        }
+
         automaticRoles_ = enabled;
         roles_.clear();
+        roleMetaObject_ = 0;
+        roleProperties_.clear();
+        notifyRoles_.clear();
+        pendingChanges_.clear();
+
+        if (automaticRoles_) {
+            // Derive the roles from the first item, as if it had just been inserted
+            auto it = std::find_if(items_.cbegin(), items_.cend(), [this](QObject *item) { return !isDestroyed(item); });
+            if (it != items_.cend()) {
+                roles_ = rolesFromItem(*it, &roleProperties_);
+                roleMetaObject_ = (*it)->metaObject();
+
+                for (QObject *item : items_) {
+                    if (!isDestroyed(item)) {
+                        trackItem(item);
+                    }
+                }
+            }
+        }
+
+        if (reset) {
+            endResetModel();
+        }
 
         emit automaticRolesChanged();
     }
@@ -105,20 +263,79 @@ bool ObjectListModel::populated() const
     return populated_;
 }
 
+void ObjectListModel::setNotifyChanges(bool enabled)
+{
+    if (enabled != notifyChanges_) {
+        if (enabled) {
+            notifyChanges_ = true;
+            for (QObject *item : items_) {
+                if (!isDestroyed(item)) {
+                    trackItem(item);
+                }
+            }
+        } else {
+            for (QObject *item : items_) {
+                if (!isDestroyed(item)) {
+                    untrackItem(item);
+                }
+            }
+            notifyChanges_ = false;
+            pendingChanges_.clear();
+            if (changedItems_.isEmpty()) {
+                changeTimer_.stop();
+            }
+        }
+
+        emit notifyChangesChanged();
+    }
+}
+
+bool ObjectListModel::notifyChanges() const
+{
+    return notifyChanges_;
+}
+
+void ObjectListModel::setBatchChanges(bool enabled)
+{
+    if (enabled != batchChanges_) {
+        batchChanges_ = enabled;
+        if (!batchChanges_ && !changedItems_.isEmpty()) {
+            // Report any changes already collected
+            reportChanges();
+        }
+
+        emit batchChangesChanged();
+    }
+}
+
+bool ObjectListModel::batchChanges() const
+{
+    return batchChanges_;
+}
+
 void ObjectListModel::insertItem(int index, QObject *item)
 {
-    if (automaticRoles_ && roles_.isEmpty() && items_.isEmpty()) {
+    if (isDestroyed(item)) {
+        // The item occupies the memory of a destroyed item, which must be removed first
+        removeDestroyedItems();
+        index = std::min<int>(index, items_.size());
+    }
+
+    if (automaticRoles_ && roles_.isEmpty() && items_.empty()) {
         // Special case: we need to derive the roles from this first item, and reset the model
-        roles_ = rolesFromItem(item);
+        roles_ = rolesFromItem(item, &roleProperties_);
+        roleMetaObject_ = item->metaObject();
+        notifyRoles_.clear();
         beginResetModel();
-        items_.insert(index, item);
+        items_.insert(items_.begin() + index, item);
         endResetModel();
     } else {
         beginInsertRows(QModelIndex(), index, index);
-        items_.insert(index, item);
-        connect(item, &QObject::destroyed, this, &ObjectListModel::objectDestroyed);
+        items_.insert(items_.begin() + index, item);
         endInsertRows();
     }
+    connect(item, &QObject::destroyed, this, &ObjectListModel::objectDestroyed);
+    trackItem(item);
 
     emit itemAdded(item);
     emit countChanged();
@@ -126,24 +343,34 @@ void ObjectListModel::insertItem(int index, QObject *item)
 
 void ObjectListModel::appendItem(QObject *item)
 {
-    insertItem(items_.count(), item);
+    insertItem(items_.size(), item);
 }
 
 void ObjectListModel::appendItems(const QList<QObject *> &items)
 {
-    if (!items.isEmpty()) {
-        if (automaticRoles_ && roles_.isEmpty() && items_.isEmpty()) {
+    insertItems(items_.size(), items);
+}
+
+void ObjectListModel::insertItems(int index, const QList<QObject *> &items)
+{
+    if (!destroyedItems_.isEmpty() && std::any_of(items.cbegin(), items.cend(), [this](QObject *item) { return isDestroyed(item); })) {
+        removeDestroyedItems();
+        index = std::min<int>(index, items_.size());
+    }
+
+    if (!items.isEmpty() && index >= 0 && index <= int(items_.size())) {
+        if (automaticRoles_ && roles_.isEmpty() && items_.empty()) {
             // Special case: we need to derive the roles from the first item
             insertItem(0, items.at(0));
-            appendItems(items.mid(1));
+            insertItems(1, items.mid(1));
             return;
         }
 
-        const int index(items_.count());
         beginInsertRows(QModelIndex(), index, (index + items.count() - 1));
+        items_.insert(items_.begin() + index, items.cbegin(), items.cend());
         for (QObject *item : items) {
-            items_.append(item);
             connect(item, &QObject::destroyed, this, &ObjectListModel::objectDestroyed);
+            trackItem(item);
         }
         endInsertRows();
 
@@ -156,22 +383,29 @@ void ObjectListModel::appendItems(const QList<QObject *> &items)
 
 void ObjectListModel::removeItem(QObject *item)
 {
-    removeItemAt(items_.indexOf(item));
+    removeDestroyedItems();
+    removeItemAt(indexOf(item));
 }
 
 void ObjectListModel::removeItems(const QList<QObject *> &items)
 {
-    QList<QPair<int, QObject *> > removals;
+    removeDestroyedItems();
+
+    // Find the removed items in a single pass, in order
+    QSet<QObject *> removed;
+    removed.reserve(items.count());
     for (QObject *item : items) {
-        int index = items_.indexOf(item);
-        if (index != -1) {
-            removals.append(qMakePair(index, item));
+        removed.insert(item);
+    }
+
+    QList<QPair<int, QObject *> > removals;
+    for (int index = 0, n = items_.size(); index < n && removals.count() < removed.count(); ++index) {
+        if (removed.contains(items_[index])) {
+            removals.append(qMakePair(index, items_[index]));
         }
     }
 
     if (!removals.isEmpty()) {
-        std::sort(removals.begin(), removals.end(), [](const QPair<int, QObject *> &lhs, const QPair<int, QObject *> &rhs) { return lhs.first < rhs.first; });
-
         int count(removals.count());
         while (count > 0) {
             // Find any contiguous runs of removal indexes to be processed together
@@ -182,12 +416,13 @@ void ObjectListModel::removeItems(const QList<QObject *> &items)
             }
 
             beginRemoveRows(QModelIndex(), removals.at(first).first, removals.at(last).first);
+            items_.erase(items_.begin() + removals.at(first).first, items_.begin() + removals.at(last).first + 1);
             while (last >= first) {
                 const QPair<int, QObject *> &removal(removals.at(last));
                 --last;
 
-                items_.removeAt(removal.first);
                 disconnect(removal.second, &QObject::destroyed, this, &ObjectListModel::objectDestroyed);
+                untrackItem(removal.second);
             }
             endRemoveRows();
 
@@ -205,14 +440,21 @@ void ObjectListModel::removeItems(const QList<QObject *> &items)
 
 void ObjectListModel::removeItemAt(int index)
 {
-    if (index >= 0 && index < items_.size()) {
-        QObject *item(items_.at(index));
+    if (index >= 0 && index < int(items_.size())) {
+        QObject *item(items_[index]);
         beginRemoveRows(QModelIndex(), index, index);
-        items_.removeAt(index);
-        disconnect(item, &QObject::destroyed, this, &ObjectListModel::objectDestroyed);
+        items_.erase(items_.begin() + index);
+        const bool destroyed(destroyedItems_.remove(item));
+        if (!destroyed) {
+            disconnect(item, &QObject::destroyed, this, &ObjectListModel::objectDestroyed);
+            untrackItem(item);
+        }
         endRemoveRows();
 
-        emit itemRemoved(item);
+        // A destroyed item was reported when it was destroyed
+        if (!destroyed) {
+            emit itemRemoved(item);
+        }
         emit countChanged();
     }
 }
@@ -220,21 +462,41 @@ void ObjectListModel::removeItemAt(int index)
 
 void ObjectListModel::moveItem(int oldIndex, int newIndex)
 {
-    if (oldIndex >= 0 && oldIndex < items_.size() && newIndex >= 0 && newIndex < items_.size()) {
-        beginMoveRows(QModelIndex(), oldIndex, oldIndex, QModelIndex(), (newIndex > oldIndex) ? (newIndex + 1) : newIndex);
-        items_.move(oldIndex, newIndex);
+    moveItems(oldIndex, 1, newIndex);
+}
+
+void ObjectListModel::moveItems(int index, int count, int newIndex)
+{
+    // The items are moved so that the first of them is at newIndex afterwards
+    const int size(items_.size());
+    if (count > 0 && index >= 0 && index + count <= size && newIndex >= 0 && newIndex + count <= size && newIndex != index) {
+        beginMoveRows(QModelIndex(), index, index + count - 1, QModelIndex(), (newIndex > index) ? (newIndex + count) : newIndex);
+        if (newIndex < index) {
+            std::rotate(items_.begin() + newIndex, items_.begin() + index, items_.begin() + index + count);
+        } else {
+            std::rotate(items_.begin() + index, items_.begin() + index + count, items_.begin() + newIndex + count);
+        }
         endMoveRows();
     }
 }
 
 void ObjectListModel::itemChanged(QObject *item)
 {
-    itemChangedAt(items_.indexOf(item));
+    itemChangedAt(indexOf(item));
 }
 
 void ObjectListModel::itemChangedAt(int index)
 {
-    if (index >= 0 && index < items_.size()) {
+    if (index >= 0 && index < int(items_.size())) {
+        if (batchChanges_) {
+            // Report the change with any others made in this event loop iteration
+            changedItems_.insert(items_[index]);
+            if (!changeTimer_.isActive()) {
+                changeTimer_.start();
+            }
+            return;
+        }
+
         const QModelIndex changedIndex(this->index(index, 0));
         emit dataChanged(changedIndex, changedIndex);
     }
@@ -242,11 +504,15 @@ void ObjectListModel::itemChangedAt(int index)
 
 void ObjectListModel::clear()
 {
-    if (items_.isEmpty())
+    removeDestroyedItems();
+
+    if (items_.empty())
         return;
 
-    beginRemoveRows(QModelIndex(), 0, items_.size());
+    beginRemoveRows(QModelIndex(), 0, items_.size() - 1);
     for (QObject *item : items_) {
+        disconnect(item, &QObject::destroyed, this, &ObjectListModel::objectDestroyed);
+        untrackItem(item);
         emit itemRemoved(item);
     }
     items_.clear();
@@ -257,17 +523,37 @@ void ObjectListModel::clear()
 
 void ObjectListModel::deleteAll()
 {
-    qDeleteAll(items_);
+    removeDestroyedItems();
+
+    // Take a copy, since the list is modified as the items are destroyed
+    const std::vector<QObject *> items(items_);
+    const bool deleting(deleting_);
+    deleting_ = true;
+    qDeleteAll(items);
+    deleting_ = deleting;
+    removeDestroyedItems();
     populated_ = false;
     
     emit countChanged();
     emit populatedChanged();
 }
 
+void ObjectListModel::deleteItems(const QList<QObject *> &items)
+{
+    removeDestroyedItems();
+
+    // The rows of the deleted items are removed together, once all of them are destroyed
+    const bool deleting(deleting_);
+    deleting_ = true;
+    qDeleteAll(items);
+    deleting_ = deleting;
+    removeDestroyedItems();
+}
+
 QObject* ObjectListModel::get(int index) const
 {
-    if (index >= 0 && index < items_.size()) {
-        QObject *item(items_.at(index));
+    if (index >= 0 && index < int(items_.size()) && !isDestroyed(items_[index])) {
+        QObject *item(items_[index]);
         QQmlEngine::setObjectOwnership(item, QQmlEngine::CppOwnership);
         return item;
     }
@@ -277,11 +563,24 @@ QObject* ObjectListModel::get(int index) const
 
 int ObjectListModel::indexOf(QObject *item) const
 {
-    return items_.indexOf(item);
+    if (isDestroyed(item))
+        return -1;
+
+    auto it = std::find(items_.cbegin(), items_.cend(), item);
+    return it != items_.cend() ? int(it - items_.cbegin()) : -1;
 }
 
 QVariant ObjectListModel::itemRole(const QObject *item, int role) const
 {
+    // Read the resolved property directly, if the item is of the type the roles were derived from
+    const size_t index(role - FirstAutomaticRole);
+    if (item->metaObject() == roleMetaObject_ && index < roleProperties_.size()) {
+        const QMetaProperty &property(roleProperties_[index]);
+        if (property.isValid()) {
+            return property.read(item);
+        }
+    }
+
     QHash<int, QByteArray>::const_iterator it = roles_.find(role);
     return it != roles_.end() ? item->property(*it) : QVariant();
 }
@@ -292,7 +591,7 @@ QVariantMap ObjectListModel::itemRoles(const QObject *item) const
 
     if (automaticRoles_) {
         for (QHash<int, QByteArray>::const_iterator it = roles_.cbegin(), end = roles_.cend(); it != end; ++it) {
-            rv.insert(QString::fromUtf8(it.value()), item->property(it.value()));
+            rv.insert(QString::fromUtf8(it.value()), itemRole(item, it.key()));
         }
     }
 
@@ -301,44 +600,79 @@ QVariantMap ObjectListModel::itemRoles(const QObject *item) const
 
 bool ObjectListModel::updateItem(QObject *item, const QVariantMap &roles)
 {
-    bool rv = false;
+    PropertyIndices indices;
+    return writeProperties(item, roles, &indices, 0);
+}
 
-    const QMetaObject *mo(item->metaObject());
-    const QList<QByteArray> dynamicPropertyNames(item->dynamicPropertyNames());
+bool ObjectListModel::updateItems(const QList<QObject *> &items, const QList<QVariantMap> &roles)
+{
+    if (items.count() != roles.count()) {
+        qWarning() << "Unable to update objects: mismatched role values";
+        return false;
+    }
 
-    for (QVariantMap::const_iterator it = roles.cbegin(), end = roles.cend(); it != end; ++it) {
-        const QByteArray roleName(it.key().toUtf8());
-        const QVariant &value(it.value());
+    // Rows and role ids are each found once for the whole update
+    QHash<QObject *, int> rows;
+    rows.reserve(items_.size());
+    for (int row = 0, n = items_.size(); row < n; ++row) {
+        rows.insert(items_[row], row);
+    }
 
-        if (dynamicPropertyNames.contains(roleName)) {
-            if (item->property(roleName) != value) {
-                item->setProperty(roleName, value);
-                rv = true;
-            }
-        } else {
-            int propertyIndex(mo->indexOfProperty(roleName));
-            if (propertyIndex != -1) {
-                QMetaProperty property(mo->property(propertyIndex));
-                if (property.isValid() && property.isWritable()) {
-                    if (property.read(item) != value) {
-                        property.write(item, value);
-
-                        QMetaMethod notify(property.notifySignal());
-                        if (notify.isValid()) {
-                            notify.invoke(item);
-                        }
-
-                        rv = true;
-                    }
-                    continue;
-                }
+    QHash<QString, int> roleIds;
+    for (QHash<int, QByteArray>::const_iterator it = roles_.cbegin(), end = roles_.cend(); it != end; ++it) {
+        roleIds.insert(QString::fromUtf8(it.value()), it.key());
+    }
+
+    bool rv = false;
+    PropertyIndices indices;
+    QStringList changed;
+
+    // The roles changed in each row, in row order; an unknown role may affect any data of the item
+    QMap<int, QSet<int> > changedRows;
+    QSet<int> unknownRoleRows;
+
+    for (int i = 0, n = items.count(); i < n; ++i) {
+        QObject *item(items.at(i));
+        changed.clear();
+        if (!writeProperties(item, roles.at(i), &indices, &changed))
+            continue;
+
+        rv = true;
+        QHash<QObject *, int>::const_iterator rit = rows.constFind(item);
+        if (rit == rows.constEnd())
+            continue;
+
+        QSet<int> &changedRoles(changedRows[*rit]);
+        for (const QString &name : changed) {
+            QHash<QString, int>::const_iterator it = roleIds.constFind(name);
+            if (it != roleIds.constEnd()) {
+                changedRoles.insert(*it);
+            } else {
+                unknownRoleRows.insert(*rit);
             }
+        }
+    }
 
-            qWarning() << "Unable to update object property:" << roleName;
+    if (changedRows.isEmpty())
+        return rv;
+
+    std::vector<QPair<int, QVector<int> > > changes;
+    changes.reserve(changedRows.count());
+    for (QMap<int, QSet<int> >::const_iterator it = changedRows.cbegin(), end = changedRows.cend(); it != end; ++it) {
+        QVector<int> roleIds;
+        if (!unknownRoleRows.contains(it.key())) {
+            roleIds.reserve(it->count() + 1);
+            for (int role : *it) {
+                roleIds.append(role);
+            }
+            roleIds.append(RoleMapRole);
+            std::sort(roleIds.begin(), roleIds.end());
         }
+        changes.push_back(qMakePair(it.key(), roleIds));
     }
+    reportRowChanges(changes);
 
-    return rv;
+    return true;
 }
 
 int ObjectListModel::rowCount(const QModelIndex &parent) const
@@ -367,8 +701,8 @@ QVariant ObjectListModel::data(const QModelIndex &index, int role) const
 
     if (role >= ObjectPointerRole) {
         const int row(index.row());
-        if (row >= 0 && row < items_.size()) {
-            QObject *item(items_.at(row));
+        if (row >= 0 && row < int(items_.size()) && !isDestroyed(items_[row])) {
+            QObject *item(items_[row]);
             if (role == ObjectPointerRole) {
                 return QVariant::fromValue(item);
             } else if (automaticRoles_) {
@@ -380,20 +714,54 @@ QVariant ObjectListModel::data(const QModelIndex &index, int role) const
     return QVariant();
 }
 
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+void ObjectListModel::multiData(const QModelIndex &index, QModelRoleDataSpan roleDataSpan) const
+{
+    QObject *item(0);
+    if (!index.parent().isValid() && index.row() >= 0 && index.row() < int(items_.size()) && !isDestroyed(items_[index.row()])) {
+        item = items_[index.row()];
+    }
+
+    // Read all the requested roles from the item in one pass
+    for (QModelRoleData &roleData : roleDataSpan) {
+        const int role(roleData.role());
+        if (!item || role < ObjectPointerRole) {
+            roleData.clearData();
+        } else if (role == ObjectPointerRole) {
+            roleData.setData(QVariant::fromValue(item));
+        } else if (!automaticRoles_) {
+            roleData.clearData();
+        } else if (role == RoleMapRole) {
+            roleData.setData(QVariant::fromValue(itemRoles(item)));
+        } else {
+            roleData.setData(itemRole(item, role));
+        }
+    }
+}
+#endif
+
 void ObjectListModel::synchronizeList(const QList<QObject *> &list)
 {
-    ::synchronizeList(this, items_, list);
+    removeDestroyedItems();
+
+    const ItemList cache = { items_ };
+    ::synchronizeList(this, cache, list);
 
     // Report addition/removals after synch completes, because a move may cause an
     // item to be both removed and added transiently
+    const bool changed(!pendingInsertions_.isEmpty() || !pendingRemovals_.isEmpty());
     for (QObject *item : insertions_) {
-        emit itemAdded(item);
+        if (pendingInsertions_.remove(item)) {
+            emit itemAdded(item);
+        }
     }
     for (QObject *item : removals_) {
-        emit itemRemoved(item);
+        if (pendingRemovals_.remove(item)) {
+            emit itemRemoved(item);
+        }
     }
 
-    if (!insertions_.isEmpty() || !removals_.isEmpty()) {
+    if (changed) {
         emit countChanged();
     }
 
@@ -401,19 +769,68 @@ void ObjectListModel::synchronizeList(const QList<QObject *> &list)
     removals_.clear();
 }
 
+void ObjectListModel::synchronizeList(const QList<QObject *> &list, const QByteArray &key)
+{
+    removeDestroyedItems();
+
+    // Index the current items by key; where keys are duplicated, the first item is matched
+    QHash<QString, QObject *> keyedItems;
+    keyedItems.reserve(items_.size());
+    for (QObject *item : items_) {
+        const QVariant value(item->property(key));
+        if (value.isValid()) {
+            const QString itemKey(value.toString());
+            if (!keyedItems.contains(itemKey)) {
+                keyedItems.insert(itemKey, item);
+            }
+        }
+    }
+
+    // Substitute the existing item for each object with a matching key
+    QList<QObject *> reference;
+    reference.reserve(list.count());
+    QList<QPair<QObject *, QObject *> > replacements;
+    for (QObject *object : list) {
+        const QVariant value(object->property(key));
+        QHash<QString, QObject *>::iterator it = value.isValid() ? keyedItems.find(value.toString()) : keyedItems.end();
+        if (it != keyedItems.end()) {
+            if (*it != object) {
+                replacements.append(qMakePair(*it, object));
+            }
+            reference.append(*it);
+            keyedItems.erase(it);
+        } else {
+            reference.append(object);
+        }
+    }
+
+    synchronizeList(reference);
+
+    // Update the surviving items in place
+    QList<QObject *> updatedItems;
+    QList<QVariantMap> updatedRoles;
+    updatedItems.reserve(replacements.count());
+    updatedRoles.reserve(replacements.count());
+    for (const QPair<QObject *, QObject *> &replacement : replacements) {
+        updatedItems.append(replacement.first);
+        updatedRoles.append(transferredProperties(replacement.second, key));
+    }
+    updateItems(updatedItems, updatedRoles);
+}
+
 int ObjectListModel::insertRange(int index, int count, const QList<QObject *> &source, int sourceIndex)
 {
     const int end = index + count - 1;
     beginInsertRows(QModelIndex(), index, end);
 
+    items_.insert(items_.begin() + index, source.cbegin() + sourceIndex, source.cbegin() + sourceIndex + count);
     for (int i = 0; i < count; ++i) {
         QObject *item(source.at(sourceIndex + i));
-        items_.insert(index + i, item);
-        int removedIndex = removals_.indexOf(item);
-        if (removedIndex != -1) {
-            removals_.removeAt(removedIndex);
-        } else {
-            insertions_.append(item);
+        connect(item, &QObject::destroyed, this, &ObjectListModel::objectDestroyed);
+        trackItem(item);
+        if (!pendingRemovals_.remove(item)) {
+            pendingInsertions_.insert(item);
+            insertions_.push_back(item);
         }
     }
 
@@ -426,16 +843,16 @@ int ObjectListModel::removeRange(int index, int count)
     const int end = index + count - 1;
     beginRemoveRows(QModelIndex(), index, end);
 
-    for (int i = 0; i < count; ++i) {
-        QObject *item(items_.at(index));
-        int insertedIndex = insertions_.indexOf(item);
-        if (insertedIndex != -1) {
-            insertions_.removeAt(insertedIndex);
-        } else {
-            removals_.append(item);
+    for (int i = index; i <= end; ++i) {
+        QObject *item(items_[i]);
+        disconnect(item, &QObject::destroyed, this, &ObjectListModel::objectDestroyed);
+        untrackItem(item);
+        if (!pendingInsertions_.remove(item)) {
+            pendingRemovals_.insert(item);
+            removals_.push_back(item);
         }
-        items_.removeAt(index);
     }
+    items_.erase(items_.begin() + index, items_.begin() + end + 1);
 
     endRemoveRows();
     return 0;
@@ -443,6 +860,173 @@ int ObjectListModel::removeRange(int index, int count)
 
 void ObjectListModel::objectDestroyed()
 {
-    removeItem(QObject::sender());
+    QObject *item(QObject::sender());
+
+    // The item is reported while it can still be referenced.  Its row is removed before returning,
+    // unless it is destroyed by deleteAll() or deleteItems(), which remove all their rows together.
+    untrackItem(item);
+    pendingChanges_.remove(item);
+    changedItems_.remove(item);
+    destroyedItems_.insert(item);
+
+    emit itemRemoved(item);
+
+    if (!deleting_) {
+        removeDestroyedItems();
+    }
+}
+
+void ObjectListModel::removeDestroyedItems()
+{
+    if (destroyedItems_.isEmpty())
+        return;
+
+    // Remove contiguous runs of destroyed items, from the end of the list
+    int removed = 0;
+    for (int last = int(items_.size()) - 1; last >= 0 && removed < destroyedItems_.count(); --last) {
+        if (!destroyedItems_.contains(items_[last]))
+            continue;
+
+        int first = last;
+        while (first > 0 && destroyedItems_.contains(items_[first - 1])) {
+            --first;
+        }
+
+        beginRemoveRows(QModelIndex(), first, last);
+        items_.erase(items_.begin() + first, items_.begin() + last + 1);
+        endRemoveRows();
+
+        removed += last - first + 1;
+        last = first;
+    }
+
+    destroyedItems_.clear();
+
+    if (removed) {
+        emit countChanged();
+    }
+}
+
+void ObjectListModel::itemPropertyChanged()
+{
+    QObject *item(sender());
+
+    const QHash<int, QVector<int> > &signalRoles(notifyRoles(item->metaObject()));
+    QHash<int, QVector<int> >::const_iterator it = signalRoles.constFind(senderSignalIndex());
+    if (it != signalRoles.constEnd()) {
+        QVector<int> &roles(pendingChanges_[item]);
+        for (int role : *it) {
+            if (!roles.contains(role)) {
+                roles.append(role);
+            }
+        }
+
+        if (!changeTimer_.isActive()) {
+            changeTimer_.start();
+        }
+    }
+}
+
+void ObjectListModel::reportChanges()
+{
+    changeTimer_.stop();
+    if (pendingChanges_.isEmpty() && changedItems_.isEmpty())
+        return;
+
+    // Find the row of each changed item still in the model; an item changed as a whole has no specific roles
+    std::vector<QPair<int, QVector<int> > > changes;
+    const size_t pendingCount(pendingChanges_.count() + changedItems_.count());
+    changes.reserve(pendingCount);
+    for (int row = 0, n = items_.size(); row < n && changes.size() < pendingCount; ++row) {
+        QObject *item(items_[row]);
+        if (changedItems_.contains(item)) {
+            changes.push_back(qMakePair(row, QVector<int>()));
+        } else {
+            QHash<QObject *, QVector<int> >::const_iterator it = pendingChanges_.constFind(item);
+            if (it != pendingChanges_.constEnd()) {
+                QVector<int> roles(*it);
+                std::sort(roles.begin(), roles.end());
+                changes.push_back(qMakePair(row, roles));
+            }
+        }
+    }
+    pendingChanges_.clear();
+    changedItems_.clear();
+
+    reportRowChanges(changes);
+}
+
+void ObjectListModel::reportRowChanges(const std::vector<QPair<int, QVector<int> > > &changes)
+{
+    // Report contiguous rows with the same changed roles together
+    for (size_t first = 0; first < changes.size(); ) {
+        size_t last = first;
+        while (last + 1 < changes.size() && changes[last + 1].first == changes[last].first + 1 && changes[last + 1].second == changes[first].second) {
+            ++last;
+        }
+
+        emit dataChanged(index(changes[first].first, 0), index(changes[last].first, 0), changes[first].second);
+        first = last + 1;
+    }
+}
+
+const QHash<int, QVector<int> > &ObjectListModel::notifyRoles(const QMetaObject *mo)
+{
+    QHash<const QMetaObject *, QHash<int, QVector<int> > >::iterator it = notifyRoles_.find(mo);
+    if (it == notifyRoles_.end()) {
+        // Find the notify signal of the property for each role, for this type of item
+        QHash<int, QVector<int> > signalRoles;
+        for (QHash<int, QByteArray>::const_iterator rit = roles_.cbegin(), end = roles_.cend(); rit != end; ++rit) {
+            const size_t index(rit.key() - FirstAutomaticRole);
+            const QMetaProperty property(mo == roleMetaObject_ && index < roleProperties_.size()
+                                             ? roleProperties_[index]
+                                             : mo->property(mo->indexOfProperty(rit.value())));
+            if (property.isValid() && property.hasNotifySignal()) {
+                signalRoles[property.notifySignalIndex()].append(rit.key());
+            }
+        }
+
+        // Any property change also changes the role map
+        for (QHash<int, QVector<int> >::iterator sit = signalRoles.begin(), end = signalRoles.end(); sit != end; ++sit) {
+            sit->append(RoleMapRole);
+        }
+
+        it = notifyRoles_.insert(mo, signalRoles);
+    }
+
+    return *it;
+}
+
+void ObjectListModel::trackItem(QObject *item)
+{
+    if (!notifyChanges_)
+        return;
+
+    const QMetaObject *mo(item->metaObject());
+    const QMetaMethod &handler(itemPropertyChangedMethod());
+
+    const QHash<int, QVector<int> > &signalRoles(notifyRoles(mo));
+    for (QHash<int, QVector<int> >::const_iterator it = signalRoles.cbegin(), end = signalRoles.cend(); it != end; ++it) {
+        connect(item, mo->method(it.key()), this, handler, Qt::UniqueConnection);
+    }
+}
+
+bool ObjectListModel::isDestroyed(QObject *item) const
+{
+    return !destroyedItems_.isEmpty() && destroyedItems_.contains(item);
+}
+
+void ObjectListModel::untrackItem(QObject *item)
+{
+    if (!notifyChanges_)
+        return;
+
+    const QMetaObject *mo(item->metaObject());
+    const QMetaMethod &handler(itemPropertyChangedMethod());
+
+    const QHash<int, QVector<int> > &signalRoles(notifyRoles(mo));
+    for (QHash<int, QVector<int> >::const_iterator it = signalRoles.cbegin(), end = signalRoles.cend(); it != end; ++it) {
+        disconnect(item, mo->method(it.key()), this, handler);
+    }
 }
 
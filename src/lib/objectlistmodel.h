@@ -35,13 +35,21 @@
 
 #include <nemomodels.h>
 #include <QAbstractListModel>
+#include <QMetaProperty>
+#include <QSet>
+#include <QTimer>
 #include <QVariantMap>
+#include <QVector>
+
+#include <vector>
 
 class NEMO_QML_PLUGIN_MODELS_EXPORT ObjectListModel : public QAbstractListModel
 {
     Q_OBJECT
     Q_PROPERTY(bool automaticRoles READ automaticRoles WRITE setAutomaticRoles NOTIFY automaticRolesChanged)
     Q_PROPERTY(bool populated READ populated WRITE setPopulated NOTIFY populatedChanged)
+    Q_PROPERTY(bool notifyChanges READ notifyChanges WRITE setNotifyChanges NOTIFY notifyChangesChanged)
+    Q_PROPERTY(bool batchChanges READ batchChanges WRITE setBatchChanges NOTIFY batchChangesChanged)
     Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
 
 public:
@@ -53,24 +61,33 @@ public:
     void setPopulated(bool populated);
     bool populated() const;
 
+    void setNotifyChanges(bool enabled);
+    bool notifyChanges() const;
+
+    void setBatchChanges(bool enabled);
+    bool batchChanges() const;
+
     int count() const { return rowCount(); }
 
     Q_INVOKABLE void insertItem(int index, QObject *item);
 
     Q_INVOKABLE void appendItem(QObject *item);
     void appendItems(const QList<QObject *> &items);
+    void insertItems(int index, const QList<QObject *> &items);
 
     Q_INVOKABLE void removeItem(QObject *item);
     void removeItems(const QList<QObject *> &items);
     Q_INVOKABLE void removeItemAt(int index);
 
     void moveItem(int oldIndex, int newIndex);
+    void moveItems(int index, int count, int newIndex);
 
     void itemChanged(QObject *item);
     void itemChangedAt(int index);
 
     Q_INVOKABLE void clear();
     void deleteAll();
+    void deleteItems(const QList<QObject *> &items);
 
     Q_INVOKABLE QObject *get(int index) const;
     Q_INVOKABLE int indexOf(QObject *item) const;
@@ -82,35 +99,77 @@ public:
     QVariantMap itemRoles(const QObject *item) const;
 
     bool updateItem(QObject *item, const QVariantMap &roles);
+    bool updateItems(const QList<QObject *> &items, const QList<QVariantMap> &roles);
 
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
     QHash<int, QByteArray> roleNames() const override;
     QVariant data(const QModelIndex &index, int role) const override;
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    void multiData(const QModelIndex &index, QModelRoleDataSpan roleDataSpan) const override;
+#endif
 
     template<typename T>
     void synchronizeList(const QList<T*> &list);
     void synchronizeList(const QList<QObject*> &list);
 
+    // Synchronizes with a list matched by the value of the key property, rather than by identity.
+    // An existing item matching an object of the list is kept, and updated with the object's properties.
+    template<typename T>
+    void synchronizeList(const QList<T*> &list, const QByteArray &key);
+    void synchronizeList(const QList<QObject*> &list, const QByteArray &key);
+
     int insertRange(int index, int count, const QList<QObject *> &source, int sourceIndex);
     int removeRange(int index, int count);
 
 private slots:
     void objectDestroyed();
+    void itemPropertyChanged();
+    void reportChanges();
 
 signals:
     void automaticRolesChanged();
     void populatedChanged();
+    void notifyChangesChanged();
+    void batchChangesChanged();
     void countChanged();
     void itemAdded(QObject *item);
     void itemRemoved(QObject *item);
 
 private:
+    const QHash<int, QVector<int> > &notifyRoles(const QMetaObject *mo);
+    void trackItem(QObject *item);
+    void untrackItem(QObject *item);
+    bool isDestroyed(QObject *item) const;
+    void removeDestroyedItems();
+    void reportRowChanges(const std::vector<QPair<int, QVector<int> > > &changes);
+
     bool automaticRoles_;
     bool populated_;
+    bool notifyChanges_;
+    bool batchChanges_;
     QHash<int, QByteArray> roles_;
-    QList<QObject*> items_;
-    QList<QObject*> insertions_;
-    QList<QObject*> removals_;
+
+    // The resolved property for each automatic role, for items of the type the roles were derived from
+    const QMetaObject *roleMetaObject_;
+    std::vector<QMetaProperty> roleProperties_;
+
+    // The roles affected by each notify signal, for each type of item
+    QHash<const QMetaObject *, QHash<int, QVector<int> > > notifyRoles_;
+    QHash<QObject *, QVector<int> > pendingChanges_;
+    QSet<QObject *> changedItems_;
+    QTimer changeTimer_;
+    std::vector<QObject *> items_;
+
+    // Items inserted and removed during synchronization, in order; only those still pending are reported
+    std::vector<QObject *> insertions_;
+    std::vector<QObject *> removals_;
+    QSet<QObject *> pendingInsertions_;
+    QSet<QObject *> pendingRemovals_;
+
+    // Items destroyed by deleteAll() or deleteItems() while the deletion is in progress; they remain
+    // in the list but are no longer readable, and are removed together once the deletion completes
+    bool deleting_;
+    QSet<QObject *> destroyedItems_;
 };
 
 template<typename T>
@@ -119,4 +178,10 @@ void ObjectListModel::synchronizeList(const QList<T*> &list)
     synchronizeList(reinterpret_cast<const QList<QObject *> &>(list));
 }
 
+template<typename T>
+void ObjectListModel::synchronizeList(const QList<T*> &list, const QByteArray &key)
+{
+    synchronizeList(reinterpret_cast<const QList<QObject *> &>(list), key);
+}
+
 #endif // OBJECTLISTMODEL_H
@@ -31,13 +31,21 @@
  */
 
 #include "searchmodel.h"
+#include "searchtokencache.h"
+#include "searchtokenpool.h"
+#include "sourcedata.h"
 
+#include <QElapsedTimer>
 #include <QSequentialIterable>
+#include <QVarLengthArray>
 #include <MLocale>
 #include <MBreakIterator>
 
 #include <QtDebug>
 
+#include <algorithm>
+#include <numeric>
+
 namespace {
 
 const ML10N::MLocale mLocale;
@@ -74,7 +82,17 @@ QMap<uint, QString> decompositionMapping()
     return rv;
 }
 
-QStringList tokenize(const QString &word)
+bool isAscii(const QString &string)
+{
+    for (const QChar c : string) {
+        if (c.unicode() >= 0x80)
+            return false;
+    }
+    return true;
+}
+
+// Returns the alternative forms that a single character (grapheme) should match
+const QStringList &characterMatches(const QString &character)
 {
 
 #if QT_VERSION < 0x051500
@@ -85,73 +103,122 @@ QStringList tokenize(const QString &word)
 
     static const QMap<uint, QString> decompositions(decompositionMapping());
 
+    // The results are invariant, so they are cached for each character encountered
+    static QHash<QString, QStringList> cache;
+
+    QHash<QString, QStringList>::const_iterator cit = cache.constFind(character);
+    if (cit != cache.constEnd()) {
+        return *cit;
+    }
+
+    QStringList matches;
+    if (alphabet.contains(character)) {
+        // This character is a member of the alphabet for this locale - do not decompose it
+        matches.append(character);
+    } else {
+        // This character is not a member of the alphabet; decompose it to
+        // assist with diacritic-insensitive matching
+        QString normalized(character.normalized(QString::NormalizationForm_D));
+        matches.append(normalized);
+
+        // For some characters, we want to match alternative spellings that do not correspond
+        // to decomposition characters
+        const uint codePoint(normalized.at(0).unicode());
+        QMap<uint, QString>::const_iterator dit = decompositions.find(codePoint);
+        if (dit != decompositions.end()) {
+            matches.append(*dit);
+        }
+    }
+
+    return *cache.insert(character, matches);
+}
+
+void appendCharacter(QStringList *tokens, const QString &character)
+{
+    const QStringList &matches(characterMatches(character));
+
+    if (tokens->isEmpty()) {
+        tokens->append(QString());
+    }
+
+    int previousCount = tokens->count();
+    for (int i = 1; i < matches.count(); ++i) {
+        // Make an additional copy of the existing tokens, for each new possible match
+        for (int j = 0; j < previousCount; ++j) {
+            tokens->append(tokens->at(j) + matches.at(i));
+        }
+    }
+    for (int j = 0; j < previousCount; ++j) {
+        (*tokens)[j].append(matches.at(0));
+    }
+}
+
+QStringList tokenize(const QString &word)
+{
+    if (word.isEmpty())
+        return QStringList();
+
+    // ASCII characters are never decomposed, and have no alternative forms
+    if (isAscii(word))
+        return QStringList(word);
+
     // Convert the word to canonical form
     QString canonical(word.normalized(QString::NormalizationForm_C));
 
     QStringList tokens;
 
+    // Below the combining diacritical marks block, every character is a grapheme in its own right
+    const bool simple = std::all_of(canonical.cbegin(), canonical.cend(), [](const QChar c) { return c.unicode() < 0x0300; });
+    if (simple) {
+        for (const QChar c : canonical) {
+            appendCharacter(&tokens, QString(c));
+        }
+        return tokens;
+    }
+
     ML10N::MBreakIterator it(mLocale, canonical, ML10N::MBreakIterator::CharacterIterator);
     while (it.hasNext()) {
         const int position = it.next();
         const int nextPosition = it.peekNext();
         if (position < nextPosition) {
-            const QString character(canonical.mid(position, (nextPosition - position)));
-            QStringList matches;
-            if (alphabet.contains(character)) {
-                // This character is a member of the alphabet for this locale - do not decompose it
-                matches.append(character);
-            } else {
-                // This character is not a member of the alphabet; decompose it to
-                // assist with diacritic-insensitive matching
-                QString normalized(character.normalized(QString::NormalizationForm_D));
-                matches.append(normalized);
-
-                // For some characters, we want to match alternative spellings that do not correspond
-                // to decomposition characters
-                const uint codePoint(normalized.at(0).unicode());
-                QMap<uint, QString>::const_iterator dit = decompositions.find(codePoint);
-                if (dit != decompositions.end()) {
-                    matches.append(*dit);
-                }
-            }
-
-            if (tokens.isEmpty()) {
-                tokens.append(QString());
-            }
-
-            int previousCount = tokens.count();
-            for (int i = 1; i < matches.count(); ++i) {
-                // Make an additional copy of the existing tokens, for each new possible match
-                for (int j = 0; j < previousCount; ++j) {
-                    tokens.append(tokens.at(j) + matches.at(i));
-                }
-            }
-            for (int j = 0; j < previousCount; ++j) {
-                tokens[j].append(matches.at(0));
-            }
+            appendCharacter(&tokens, canonical.mid(position, (nextPosition - position)));
         }
     }
 
     return tokens;
 }
 
-QList<const QString *> makeSearchToken(const QString &word)
+QString toLower(const QString &string)
+{
+    // Locale-aware conversion is only needed outside ASCII, or for the dotless i of Turkic languages
+    static const bool turkic(mLocale.language() == QLatin1String("tr") || mLocale.language() == QLatin1String("az"));
+    if (!turkic && isAscii(string)) {
+        return string.toLower();
+    }
+
+    return mLocale.toLower(string);
+}
+
+// The result is valid until the next invocation
+const std::vector<quint32> &makeSearchToken(const QString &word)
 {
-    static QMap<uint, const QString *> indexedTokens;
-    static QHash<QString, QList<const QString *> > indexedWords;
+    static QHash<QString, std::vector<quint32> > indexedWords;
+    static quint32 generation = 0;
+
+    SearchTokenPool *pool = SearchTokenPool::instance();
+    if (generation != pool->generation()) {
+        // The indexed tokens have been discarded from the pool
+        indexedWords.clear();
+        generation = pool->generation();
+    }
 
-    QHash<QString, QList<const QString *> >::const_iterator wit = indexedWords.find(word);
-    if (wit == indexedWords.end()) {
-        QList<const QString *> indexed;
+    QHash<QString, std::vector<quint32> >::const_iterator wit = indexedWords.constFind(word);
+    if (wit == indexedWords.constEnd()) {
+        std::vector<quint32> indexed;
 
         // Index these tokens for later dereferencing
         for (const QString &token : tokenize(word)) {
-            uint hashValue(qHash(token));
-            QMap<uint, const QString *>::const_iterator tit = indexedTokens.find(hashValue);
-            if (tit == indexedTokens.end()) {
-                tit = indexedTokens.insert(hashValue, new QString(token));
-            }
-            indexed.append(*tit);
+            indexed.push_back(pool->intern(token));
         }
 
         wit = indexedWords.insert(word, indexed);
@@ -187,35 +254,56 @@ QStringList splitWords(const QString &string)
     return rv;
 }
 
-QList<const QString *> searchTokens(const QString &string)
+void appendSearchTokens(SearchModel::Tokens *tokens, const QString &string, int *position)
 {
-    QList<const QString *> rv;
-
     for (const QString &word : splitWords(string)) {
-        for (const QString *alternative : makeSearchToken(word)) {
-            rv.append(alternative);
+        const quint8 wordPosition(qMin(*position, 255));
+        for (quint32 alternative : makeSearchToken(word)) {
+            tokens->text.push_back(alternative);
+            tokens->position.push_back(wordPosition);
         }
+        ++(*position);
     }
-
-    return rv;
 }
 
-struct LessThanIndirect {
-    template<typename T>
-    bool operator()(T lhs, T rhs) const { return *lhs < *rhs; }
-};
+void copySorted(const SearchModel::Tokens &src, SearchModel::Tokens *dst)
+{
+    typedef std::pair<quint32, quint8> Token;
+
+    const SearchTokenPool *pool = SearchTokenPool::instance();
+
+    std::vector<Token> tokens;
+    tokens.reserve(src.text.size());
+    for (size_t i = 0, n = src.text.size(); i < n; ++i) {
+        tokens.push_back(std::make_pair(src.text[i], src.position[i]));
+    }
+
+    // Where a token occurs more than once, retain only its earliest position
+    std::sort(tokens.begin(), tokens.end(), [pool](const Token &lhs, const Token &rhs) {
+        return (lhs.first == rhs.first) ? (lhs.second < rhs.second) : pool->lessThan(lhs.first, rhs.first);
+    });
+    tokens.erase(std::unique(tokens.begin(), tokens.end(), [](const Token &lhs, const Token &rhs) { return lhs.first == rhs.first; }), tokens.end());
+
+    dst->text.reserve(tokens.size());
+    dst->position.reserve(tokens.size());
+    for (const Token &token : tokens) {
+        dst->text.push_back(token.first);
+        dst->position.push_back(token.second);
+    }
+}
 
-struct EqualIndirect {
-    template<typename T>
-    bool operator()(T lhs, T rhs) const { return *lhs == *rhs; }
+// The tokens of a row, in one of the case sensitive or lowered forms
+struct TokenView {
+    const quint32 *text;
+    const quint8 *position;
+    size_t count;
 };
 
-struct FirstElementLessThanIndirect {
-    template<typename Container>
-    bool operator()(const Container *lhs, typename Container::const_iterator rhs) { return *lhs->cbegin() < *rhs; }
+struct FirstCharacterLessThan {
+    const SearchTokenPool *pool;
 
-    template<typename Container>
-    bool operator()(typename Container::const_iterator lhs, const Container *rhs) { return *lhs < *rhs->cbegin(); }
+    bool operator()(quint32 lhs, QChar rhs) const { return *pool->begin(lhs) < rhs; }
+    bool operator()(QChar lhs, quint32 rhs) const { return lhs < *pool->begin(rhs); }
 };
 
 QStringList toStringList(const QVariant &value)
@@ -242,51 +330,93 @@ QStringList toStringList(const QVariant &value)
     return rv;
 }
 
-void appendTokens(SearchModel::TokenList *tokens, const QVariant &value)
+void appendTokens(SearchModel::TokenList *tokens, const QStringList &value, int forms, int *position)
 {
-    for (const QString &item : toStringList(value)) {
-        for (const QString *word : searchTokens(item)) {
-            tokens->first.push_back(word);
+    for (const QString &item : value) {
+        int casedPosition(*position);
+        if (forms & SearchModel::CaseSensitiveTokens) {
+            appendSearchTokens(&tokens->first, item, &casedPosition);
         }
 
-        // Also index search text in lower case for case insensitive search
-        const QString lowered(mLocale.toLower(item));
-        for (const QString *word : searchTokens(lowered)) {
-            tokens->second.push_back(word);
+        // Index search text in lower case for case insensitive search
+        int loweredPosition(*position);
+        if (forms & SearchModel::LoweredTokens) {
+            const QString lowered(toLower(item));
+            appendSearchTokens(&tokens->second, lowered, &loweredPosition);
         }
+
+        *position = (forms & SearchModel::CaseSensitiveTokens) ? casedPosition : loweredPosition;
     }
 }
 
-QList<QStringList> patternTokens(const QString &string, Qt::CaseSensitivity caseSensitive)
+// FNV-1a, which is stable between processes and can therefore identify persisted content
+const quint64 HashBasis = Q_UINT64_C(0xcbf29ce484222325);
+
+quint64 hashString(quint64 hash, const QString &string)
 {
-    QList<QStringList> rv;
+    for (const QChar *it = string.constData(), *end = it + string.length(); it != end; ++it) {
+        hash = (hash ^ it->unicode()) * Q_UINT64_C(0x100000001b3);
+    }
+    // Terminate each string, so that the division between strings is also hashed
+    return (hash ^ 0xffff) * Q_UINT64_C(0x100000001b3);
+}
+
+quint64 hashValues(const QList<QStringList> &values)
+{
+    quint64 rv = HashBasis;
+    for (const QStringList &value : values) {
+        for (const QString &item : value) {
+            rv = hashString(rv, item);
+        }
+        rv = hashString(rv, QString());
+    }
+    return rv;
+}
 
+// Discard any cached distances for alternatives not present in the current patterns
+void retainDistances(QHash<QString, QHash<quint32, int>> *distances, const QList<QStringList> &patterns)
+{
+    for (auto it = distances->begin(); it != distances->end(); ) {
+        const bool present = std::any_of(patterns.cbegin(), patterns.cend(), [&it](const QStringList &part) { return part.contains(it.key()); });
+        if (present) {
+            ++it;
+        } else {
+            it = distances->erase(it);
+        }
+    }
+}
+
+QStringList patternWords(const QString &string, Qt::CaseSensitivity caseSensitive)
+{
     // Test case insensitive searches in lower case
-    const QString pattern(caseSensitive == Qt::CaseInsensitive ? mLocale.toLower(string) : string);
-    for (const QString &word : splitWords(pattern)) {
+    return splitWords(caseSensitive == Qt::CaseInsensitive ? toLower(string) : string);
+}
+
+QList<QStringList> patternTokens(const QStringList &words)
+{
+    QList<QStringList> rv;
+    for (const QString &word : words) {
         rv.append(tokenize(word));
     }
-
     return rv;
 }
 
-static const QChar *cbegin(const QString &s) { return s.cbegin(); }
-static const QChar *cend(const QString &s) { return s.cend(); }
+enum MatchQuality {
+    NoMatch = 0,
+    InfixMatch,
+    PrefixMatch,
+    ExactMatch
+};
 
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-static const QChar *cbegin(const QStringView &r) { return r.data(); }
-static const QChar *cend(const QStringView &r) { return r.data() + r.size(); }
-#else
-static const QChar *cbegin(const QStringRef &r) { return r.data(); }
-static const QChar *cend(const QStringRef &r) { return r.data() + r.size(); }
-#endif
+int matchScore(int quality, int position)
+{
+    // The quality of the match is dominant; earlier tokens are preferred for equal quality
+    return (quality << 8) + (255 - position);
+}
 
-template <typename StringType>
-bool partialMatch(const StringType &key, const QChar * const vbegin, const QChar * const vend)
+int partialMatch(const QChar * const kbegin, const QChar * const kend, const QChar * const vbegin, const QChar * const vend)
 {
     // Note: both key and value must already be in normalization form D
-    const QChar *kbegin = cbegin(key), *kend = cend(key);
-
     const QChar *vit = vbegin, *kit = kbegin;
     while (kit != kend) {
         if (*kit != *vit)
@@ -311,66 +441,248 @@ bool partialMatch(const StringType &key, const QChar * const vbegin, const QChar
 
         if (vit == vend) {
             // We have matched to the end of the value
-            return true;
+            return (kit == kend) ? ExactMatch : PrefixMatch;
         }
     }
 
-    return false;
+    return NoMatch;
 }
 
-bool partialMatch(const std::vector<const QString *> &tokens, const QString &value, SearchModel::MatchType type)
+QString stripDiacritics(const QChar *begin, const QChar *end)
 {
+    QString rv;
+    rv.reserve(end - begin);
+    for (const QChar *it = begin; it != end; ++it) {
+        if (it->category() != QChar::Mark_NonSpacing)
+            rv.append(*it);
+    }
+    return rv;
+}
+
+int fuzzyBound(int patternLength, int maximumDistance)
+{
+    // At least half of the pattern must be matched, so that very short patterns do not match everything
+    return qMax(qMin(maximumDistance, (patternLength - 1) / 2), 0);
+}
+
+// Returns true if every item matched by all of the narrower parts is also matched by all of
+// the broader parts.  Each broader part must be implied by some narrower part, since every
+// part of a pattern must be matched.  A fuzzy part's prefix distance cannot decrease as it is
+// extended, but the permitted distance grows with its length, so that must be unchanged.
+bool patternImplies(const QStringList &narrower, const QStringList &broader, SearchModel::MatchType type, int maximumDistance)
+{
+    auto bound = [maximumDistance](const QString &word) {
+        return fuzzyBound(stripDiacritics(word.cbegin(), word.cend()).length(), maximumDistance);
+    };
+
+    return std::all_of(broader.cbegin(), broader.cend(), [&narrower, type, &bound](const QString &broad) {
+        return std::any_of(narrower.cbegin(), narrower.cend(), [&broad, type, &bound](const QString &narrow) {
+            if (type == SearchModel::MatchAnywhere)
+                return narrow.contains(broad);
+            return narrow.startsWith(broad) && (type != SearchModel::MatchFuzzy || bound(narrow) == bound(broad));
+        });
+    });
+}
+
+// Returns the smallest edit distance between the pattern and any prefix of the text,
+// or (maximum + 1) if there is no prefix within that distance
+int prefixDistance(const QString &pattern, const QString &text, int maximum)
+{
+    const int m(pattern.length());
+    const int n(text.length());
+    if (m == 0)
+        return 0;
+    if (n < m - maximum)
+        return maximum + 1;
+
+    int best = m;
+
+    if (m > 64) {
+        // Too long for a single bit-vector; use the dynamic programming formulation
+        std::vector<int> column(m + 1);
+        std::iota(column.begin(), column.end(), 0);
+        for (int j = 0; j < n && best > 0; ++j) {
+            int diagonal = column[0];
+            column[0] = j + 1;
+            for (int i = 1; i <= m; ++i) {
+                const int above = column[i];
+                column[i] = qMin(qMin(above, column[i - 1]) + 1, diagonal + (pattern.at(i - 1) == text.at(j) ? 0 : 1));
+                diagonal = above;
+            }
+            best = qMin(best, column[m]);
+        }
+        return best > maximum ? (maximum + 1) : best;
+    }
+
+    // Myers' bit-parallel algorithm, in Hyyrö's formulation for edit distance
+    QVarLengthArray<QPair<QChar, quint64>, 64> peq;
+    for (int i = 0; i < m; ++i) {
+        const QChar c(pattern.at(i));
+        auto it = std::find_if(peq.begin(), peq.end(), [c](const QPair<QChar, quint64> &pair) { return pair.first == c; });
+        if (it == peq.end()) {
+            peq.append(qMakePair(c, quint64(1) << i));
+        } else {
+            it->second |= (quint64(1) << i);
+        }
+    }
+
+    const quint64 highBit(quint64(1) << (m - 1));
+    quint64 pv = ~quint64(0);
+    quint64 mv = 0;
+    int score = m;
+
+    for (int j = 0; j < n; ++j) {
+        const QChar c(text.at(j));
+        quint64 eq = 0;
+        for (auto it = peq.cbegin(), end = peq.cend(); it != end; ++it) {
+            if (it->first == c) {
+                eq = it->second;
+                break;
+            }
+        }
+
+        const quint64 xv = eq | mv;
+        const quint64 xh = (((eq & pv) + pv) ^ pv) | eq;
+        quint64 ph = mv | ~(xh | pv);
+        quint64 mh = pv & xh;
+        if (ph & highBit) {
+            ++score;
+        } else if (mh & highBit) {
+            --score;
+        }
+        ph = (ph << 1) | 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+
+        best = qMin(best, score);
+        if (best == 0 || (score - (n - j - 1)) > maximum) {
+            // No better prefix can be found
+            break;
+        }
+    }
+
+    return best > maximum ? (maximum + 1) : best;
+}
+
+// If score is non-null, all tokens are tested to find the best scoring match
+bool partialMatch(const TokenView &tokens, const QString &value, SearchModel::MatchType type, int maximumDistance, QHash<quint32, int> *distances, int *score)
+{
+    const SearchTokenPool *pool = SearchTokenPool::instance();
     const QChar *vbegin = value.cbegin(), *vend = value.cend();
+    const quint32 *tbegin = tokens.text, *tend = tokens.text + tokens.count;
+    int bestScore = 0;
 
     if (type == SearchModel::MatchBeginning) {
         // Find which subset of keys the value might match
-        typedef std::vector<const QString *>::const_iterator VectorIterator;
-        std::pair<VectorIterator, VectorIterator> bounds = std::equal_range(tokens.cbegin(), tokens.cend(), vbegin, FirstElementLessThanIndirect());
+        std::pair<const quint32 *, const quint32 *> bounds = std::equal_range(tbegin, tend, *vbegin, FirstCharacterLessThan{pool});
         for ( ; bounds.first != bounds.second; ++bounds.first) {
-            const QString &key(*(*bounds.first));
-            if (partialMatch(key, vbegin, vend))
-                return true;
+            const quint32 key(*bounds.first);
+            if (const int quality = partialMatch(pool->begin(key), pool->end(key), vbegin, vend)) {
+                if (!score)
+                    return true;
+
+                const int position(tokens.position[bounds.first - tbegin]);
+                bestScore = qMax(bestScore, matchScore(quality, position));
+            }
         }
     } else if (type == SearchModel::MatchAnywhere) {
         // Test all tokens that contain the initial character (in normalization form D)
-        for (const QString *token : tokens) {
+        for (const quint32 *tit = tbegin; tit != tend; ++tit) {
             // Test each possible location in the token
-            for (auto begin = token->cbegin(), it = begin, end = token->cend(); it != end; ) {
+            for (const QChar *begin = pool->begin(*tit), *it = begin, *end = pool->end(*tit); it != end; ) {
                 it = std::find(it, end, *vbegin);
                 if (it != end) {
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-                    const QStringView key = QStringView(&(*it), end - it);
-#else
-                    const QStringRef key(token->midRef((it - begin)));
-#endif
-                    if (partialMatch(key, vbegin, vend))
-                        return true;
+                    if (const int quality = partialMatch(it, end, vbegin, vend)) {
+                        if (!score)
+                            return true;
+
+                        // The earliest location in this token is the best match it can provide
+                        const int position(tokens.position[tit - tbegin]);
+                        bestScore = qMax(bestScore, matchScore((it == begin ? quality : InfixMatch), position));
+                        break;
+                    }
 
                     ++it;
                 }
             }
         }
+    } else if (type == SearchModel::MatchFuzzy) {
+        // Tokens are interned, so each token's distance from the value is only calculated once
+        const QString pattern(stripDiacritics(vbegin, vend));
+        const int maximum(fuzzyBound(pattern.length(), maximumDistance));
+        for (const quint32 *tit = tbegin; tit != tend; ++tit) {
+            const quint32 token(*tit);
+
+            auto dit = distances->find(token);
+            if (dit == distances->end()) {
+                dit = distances->insert(token, prefixDistance(pattern, stripDiacritics(pool->begin(token), pool->end(token)), maximum));
+            }
+            if (*dit <= maximum) {
+                if (!score)
+                    return true;
+
+                int quality = InfixMatch;
+                if (*dit == 0) {
+                    quality = qMax<int>(partialMatch(pool->begin(token), pool->end(token), vbegin, vend), InfixMatch);
+                }
+                const int position(tokens.position[tit - tbegin]);
+                bestScore = qMax(bestScore, matchScore(quality, position));
+            }
+        }
+    }
+
+    if (bestScore > 0) {
+        *score = bestScore;
+        return true;
     }
 
     return false;
 }
 
-bool matchTokens(const std::vector<const QString *> &tokens, const QList<QStringList> &patterns, SearchModel::MatchType type)
+// If score is non-null, it is set to the best match score for any alternative of the part
+bool matchPart(const TokenView &tokens, const QStringList &part, SearchModel::MatchType type, int maximumDistance, QHash<QString, QHash<quint32, int>> *distances, int *score)
 {
-    for (const QStringList &part : patterns) {
-        bool match = false;
-        for (const QString &alternative : part) {
-            if (partialMatch(tokens, alternative, type)) {
-                match = true;
+    bool match = false;
+    int partScore = 0;
+    for (const QString &alternative : part) {
+        int alternativeScore = 0;
+        QHash<quint32, int> *alternativeDistances(type == SearchModel::MatchFuzzy ? &(*distances)[alternative] : 0);
+        if (partialMatch(tokens, alternative, type, maximumDistance, alternativeDistances, score ? &alternativeScore : 0)) {
+            match = true;
+            if (!score)
                 break;
-            }
-        }
-        if (!match) {
-            return false;
+
+            partScore = qMax(partScore, alternativeScore);
         }
     }
 
-    return true;
+    if (match && score) {
+        *score = partScore;
+    }
+    return match;
+}
+
+// Memoized results of matching a pattern part against a row; scored results are offset by ScoredMatch
+const quint16 UnknownMatch = 0;
+const quint16 NoPartMatch = 1;
+const quint16 UnscoredMatch = 2;
+const quint16 ScoredMatch = 3;
+
+QString tokenConfiguration(const QStringList &roleNames, const QStringList &propertyNames)
+{
+    return roleNames.join(QLatin1Char('\n')) + QLatin1Char('\t') + propertyNames.join(QLatin1Char('\n'));
+}
+
+// Moves a block of per-item values to the given index in the remaining values
+template<typename T>
+void moveElements(std::vector<T> *values, int index, int count, int destination)
+{
+    if (destination < index) {
+        std::rotate(values->begin() + destination, values->begin() + index, values->begin() + index + count);
+    } else {
+        std::rotate(values->begin() + index, values->begin() + index + count, values->begin() + destination + count);
+    }
 }
 
 }
@@ -380,15 +692,40 @@ SearchModel::SearchModel(QObject *parent)
     : BaseFilterModel(parent)
     , sensitivity_(Qt::CaseSensitive)
     , matchType_(MatchBeginning)
+    , maximumDistance_(1)
+    , sortByRelevance_(false)
+    , allTokenForms_(false)
+    , pretokenize_(false)
+    , unusedTokens_(0)
+    , tokenCacheRole_(-2)
+    , pretokenizeRow_(0)
+    , tokenizedRows_(0)
+    , tokenizedForms_(0)
+    , tokenizationProgress_(1.0)
 {
+    pretokenizeTimer_.setSingleShot(true);
+    pretokenizeTimer_.setInterval(0);
+    connect(&pretokenizeTimer_, &QTimer::timeout, this, &SearchModel::pretokenizeItems);
+    SearchTokenPool::acquire(this, [this](std::vector<bool> *live) { markTokens(live); });
+    connect(this, &BaseFilterModel::populatedChanged, this, [this]() { schedulePretokenization(pretokenizeRow_); });
+}
+
+SearchModel::~SearchModel()
+{
+    closeTokenCache();
+    SearchTokenPool::release(this);
 }
 
 void SearchModel::setSearchRoles(const QStringList &roles)
 {
     if (roles != roleNames_) {
+        closeTokenCache();
+
         roleNames_ = roles;
+        tokenConfiguration_ = tokenConfiguration(roleNames_, propertyNames_);
         roles_.clear();
         searchTokensInvalidated();
+        openTokenCache();
 
         if (populated_ && model_) {
             buildMapping();
@@ -406,9 +743,13 @@ QStringList SearchModel::searchRoles() const
 void SearchModel::setSearchProperties(const QStringList &properties)
 {
     if (properties != propertyNames_) {
+        closeTokenCache();
+
         propertyNames_ = properties;
+        tokenConfiguration_ = tokenConfiguration(roleNames_, propertyNames_);
         properties_.clear();
         searchTokensInvalidated();
+        openTokenCache();
 
         if (populated_ && model_) {
             buildMapping();
@@ -426,19 +767,39 @@ QStringList SearchModel::searchProperties() const
 void SearchModel::setPattern(const QString &pattern)
 {
     if (pattern != pattern_) {
-        const bool refinement(!pattern_.isEmpty() && pattern.startsWith(pattern_));
-        const bool unrefinement(pattern_.startsWith(pattern));
+        const QStringList words(patternWords(pattern, sensitivity_));
+
+        // Every part must be matched, so the change can be evaluated per part: a part that
+        // is added or extended can only exclude items, and one removed or shortened can only
+        // include them, whatever its position in the pattern
+        const bool refinement(!pattern_.isEmpty() && patternImplies(words, patternWords_, matchType_, maximumDistance_));
+        const bool unrefinement(patternImplies(patternWords_, words, matchType_, maximumDistance_));
+        const bool wasRanked(ranked());
 
         pattern_ = pattern;
-        patterns_ = patternTokens(pattern_, sensitivity_);
+        patternWords_ = words;
+        patterns_ = patternTokens(patternWords_);
+        retainDistances(&distances_, patterns_);
+        updatePartMatches();
 
         if (populated_ && model_) {
-            if (refinement) {
+            if (wasRanked && !ranked()) {
+                // Restore the source order before any items are included
+                sortMapping();
+            }
+
+            if (refinement && unrefinement) {
+                // The same items are matched, although their relevance may differ
+                if (ranked()) {
+                    refineMapping();
+                }
+            } else if (refinement) {
                 refineMapping();
             } else if (unrefinement) {
                 unrefineMapping();
             } else {
-                buildMapping();
+                // Report only the differences between the previous and current results
+                updateMapping(0, model_->rowCount() - 1);
             }
         }
 
@@ -455,7 +816,16 @@ void SearchModel::setCaseSensitivity(Qt::CaseSensitivity sensitivity)
 {
     if (sensitivity != sensitivity_) {
         sensitivity_ = sensitivity;
-        patterns_ = patternTokens(pattern_, sensitivity_);
+        patternWords_ = patternWords(pattern_, sensitivity_);
+        patterns_ = patternTokens(patternWords_);
+        retainDistances(&distances_, patterns_);
+        partMatches_.clear();
+        updatePartMatches();
+
+        // Tokens are only generated for the form required; once the sensitivity has changed,
+        // generate both forms since the other is likely to be required again
+        allTokenForms_ = true;
+        schedulePretokenization(0);
 
         if (populated_ && model_) {
             const bool refinement(!pattern_.isEmpty() && sensitivity_ == Qt::CaseSensitive);
@@ -482,6 +852,7 @@ void SearchModel::setMatchType(MatchType type)
 {
     if (type != matchType_) {
         matchType_ = type;
+        partMatchesInvalidated();
 
         if (populated_ && model_) {
             buildMapping();
@@ -496,6 +867,221 @@ SearchModel::MatchType SearchModel::matchType() const
     return matchType_;
 }
 
+void SearchModel::setSortByRelevance(bool enabled)
+{
+    if (enabled != sortByRelevance_) {
+        sortByRelevance_ = enabled;
+
+        if (populated_ && model_) {
+            if (ranked()) {
+                // Score the mapped items, and sort them by their ranking
+                refineMapping();
+            } else {
+                sortMapping();
+            }
+        }
+
+        emit sortByRelevanceChanged();
+    }
+}
+
+void SearchModel::setMaximumEditDistance(int distance)
+{
+    distance = qMax(distance, 0);
+    if (distance != maximumDistance_) {
+        const bool refinement(distance < maximumDistance_);
+        maximumDistance_ = distance;
+        distances_.clear();
+        if (matchType_ == MatchFuzzy) {
+            partMatchesInvalidated();
+        }
+
+        if (populated_ && model_ && matchType_ == MatchFuzzy) {
+            if (refinement) {
+                refineMapping();
+            } else {
+                unrefineMapping();
+            }
+        }
+
+        emit maximumEditDistanceChanged();
+    }
+}
+
+int SearchModel::maximumEditDistance() const
+{
+    return maximumDistance_;
+}
+
+bool SearchModel::sortByRelevance() const
+{
+    return sortByRelevance_;
+}
+
+void SearchModel::setTokenCacheFile(const QString &fileName)
+{
+    if (fileName != tokenCacheFile_) {
+        closeTokenCache();
+        tokenCacheFile_ = fileName;
+        openTokenCache();
+
+        emit tokenCacheFileChanged();
+    }
+}
+
+QString SearchModel::tokenCacheFile() const
+{
+    return tokenCacheFile_;
+}
+
+void SearchModel::setTokenCacheKeyRole(const QString &roleName)
+{
+    if (roleName != tokenCacheKeyRole_) {
+        closeTokenCache();
+        tokenCacheKeyRole_ = roleName;
+        tokenCacheRole_ = -2;
+        openTokenCache();
+
+        emit tokenCacheKeyRoleChanged();
+    }
+}
+
+QString SearchModel::tokenCacheKeyRole() const
+{
+    return tokenCacheKeyRole_;
+}
+
+bool SearchModel::saveTokenCache()
+{
+    if (!tokenCache_ || !tokenCache_->modified()) {
+        return true;
+    }
+
+    // If every row has been tokenized, entries for rows no longer present can be discarded
+    const bool complete(!tokenSpans_.empty()
+                        && std::none_of(tokenSpans_.cbegin(), tokenSpans_.cend(), [](const TokenSpan &span) { return span.forms != AllTokens; }));
+    return tokenCache_->save(complete);
+}
+
+void SearchModel::openTokenCache()
+{
+    if (tokenCacheFile_.isEmpty() || tokenCacheKeyRole_.isEmpty()) {
+        return;
+    }
+
+    // Persisted tokens are only valid for the configuration that produced them
+    quint64 configuration = HashBasis;
+    configuration = hashString(configuration, roleNames_.join(QChar(',')));
+    configuration = hashString(configuration, propertyNames_.join(QChar(',')));
+    configuration = hashString(configuration, mLocale.name());
+
+    tokenCache_.reset(new SearchTokenCache(tokenCacheFile_, configuration));
+
+    // Regenerate any existing tokens via the cache, so that they will be included when it is saved
+    searchTokensInvalidated();
+}
+
+void SearchModel::closeTokenCache()
+{
+    if (tokenCache_) {
+        saveTokenCache();
+        tokenCache_.reset();
+    }
+}
+
+void SearchModel::setPretokenize(bool enabled)
+{
+    if (enabled != pretokenize_) {
+        pretokenize_ = enabled;
+        if (pretokenize_) {
+            schedulePretokenization(pretokenizeRow_);
+        } else {
+            pretokenizeTimer_.stop();
+
+            // Nothing is pending without pretokenization
+            if (tokenizationProgress_ != 1.0) {
+                tokenizationProgress_ = 1.0;
+                emit tokenizationProgressChanged();
+            }
+        }
+
+        emit pretokenizeChanged();
+    }
+}
+
+bool SearchModel::pretokenize() const
+{
+    return pretokenize_;
+}
+
+qreal SearchModel::tokenizationProgress() const
+{
+    return tokenizationProgress_;
+}
+
+void SearchModel::schedulePretokenization(int sourceRow)
+{
+    pretokenizeRow_ = qMin(pretokenizeRow_, sourceRow);
+    updateTokenizationProgress();
+
+    if (pretokenize_ && model_ && pretokenizeRow_ < static_cast<int>(tokenSpans_.size())) {
+        pretokenizeTimer_.start();
+    }
+}
+
+void SearchModel::updateTokenizationProgress()
+{
+    if (!pretokenize_) {
+        return;
+    }
+
+    // Rows are counted for the forms they hold; recount them when the forms required change
+    const int forms(tokenForms());
+    if (forms != tokenizedForms_) {
+        tokenizedForms_ = forms;
+        tokenizedRows_ = static_cast<int>(std::count_if(tokenSpans_.cbegin(), tokenSpans_.cend(), [forms](const TokenSpan &span) { return (span.forms & forms) == forms; }));
+    }
+
+    const int count(tokenSpans_.size());
+    const qreal progress(count ? static_cast<qreal>(tokenizedRows_) / count : 1.0);
+    if (progress != tokenizationProgress_) {
+        tokenizationProgress_ = progress;
+        emit tokenizationProgressChanged();
+    }
+}
+
+void SearchModel::pretokenizeItems()
+{
+    if (!pretokenize_ || !populated_ || !model_) {
+        return;
+    }
+
+    // Tokenize in small increments, so that the event loop is not blocked
+    const qint64 maximumDuration = 8;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    const int count(tokenSpans_.size());
+    while (pretokenizeRow_ < count) {
+        if (!hasTokens(pretokenizeRow_, tokenForms())) {
+            const int forms(tokenForms() & ~tokenSpans_[pretokenizeRow_].forms);
+            storeTokens(pretokenizeRow_, searchTokens(pretokenizeRow_, forms), forms);
+        }
+        ++pretokenizeRow_;
+
+        if (timer.elapsed() >= maximumDuration) {
+            break;
+        }
+    }
+
+    updateTokenizationProgress();
+
+    if (pretokenizeRow_ < count) {
+        pretokenizeTimer_.start();
+    }
+}
+
 bool SearchModel::filtered() const
 {
     return !pattern_.isEmpty();
@@ -506,17 +1092,88 @@ bool SearchModel::includeItem(int sourceRow) const
     if (pattern_.isEmpty())
         return true;
 
-    std::shared_ptr<TokenList> &itemTokens = tokens_.at(sourceRow);
-    if (!itemTokens) {
-        itemTokens = std::move(searchTokens(sourceRow));
+    // Any part already known not to match excludes this item
+    for (const PartMatches &matches : partMatches_) {
+        if (matches.results[sourceRow] == NoPartMatch) {
+            return false;
+        }
+    }
+
+    const bool scored(ranked());
+    int totalScore = 0;
+    bool tokensResolved = false;
+    TokenView tokens;
+
+    for (size_t i = 0, n = partMatches_.size(); i < n; ++i) {
+        quint16 &result(partMatches_[i].results[sourceRow]);
+        if (result == UnknownMatch || (scored && result == UnscoredMatch)) {
+            if (!tokensResolved) {
+                const int form(sensitivity_ == Qt::CaseInsensitive ? LoweredTokens : CaseSensitiveTokens);
+                if (!hasTokens(sourceRow, form)) {
+                    const int forms(tokenForms() & ~tokenSpans_.at(sourceRow).forms);
+                    storeTokens(sourceRow, searchTokens(sourceRow, forms), forms);
+                }
+
+                const TokenSpan &span(tokenSpans_.at(sourceRow));
+                if (sensitivity_ == Qt::CaseInsensitive) {
+                    tokens.text = tokenIds_.data() + span.offset + span.count;
+                    tokens.position = tokenPositions_.data() + span.offset + span.count;
+                    tokens.count = span.loweredCount;
+                } else {
+                    tokens.text = tokenIds_.data() + span.offset;
+                    tokens.position = tokenPositions_.data() + span.offset;
+                    tokens.count = span.count;
+                }
+                tokensResolved = true;
+            }
+
+            int score = 0;
+            if (matchPart(tokens, patterns_.at(i), matchType_, maximumDistance_, &distances_, scored ? &score : 0)) {
+                result = scored ? static_cast<quint16>(score + ScoredMatch) : UnscoredMatch;
+            } else {
+                result = NoPartMatch;
+            }
+        }
+
+        if (result == NoPartMatch) {
+            return false;
+        }
+        totalScore += (result >= ScoredMatch ? result - ScoredMatch : 0);
     }
 
-    return matchTokens((sensitivity_ == Qt::CaseInsensitive ? itemTokens->second : itemTokens->first), patterns_, matchType_);
+    if (scored) {
+        scores_.at(sourceRow) = totalScore;
+    }
+    return true;
+}
+
+bool SearchModel::ranked() const
+{
+    return sortByRelevance_ && !pattern_.isEmpty();
+}
+
+bool SearchModel::lessThan(int lhsSourceRow, int rhsSourceRow) const
+{
+    // Higher scores are ranked first, otherwise retain the source order
+    if (!ranked())
+        return BaseFilterModel::lessThan(lhsSourceRow, rhsSourceRow);
+
+    const int lhsScore(scores_.at(lhsSourceRow));
+    const int rhsScore(scores_.at(rhsSourceRow));
+    return lhsScore > rhsScore || (lhsScore == rhsScore && lhsSourceRow < rhsSourceRow);
 }
 
-std::unique_ptr<SearchModel::TokenList> SearchModel::searchTokens(int sourceRow) const
+SearchModel::TokenList SearchModel::searchTokens(int sourceRow, int forms) const
 {
-    auto rv = new TokenList;
+    TokenList rv;
+
+    // Reuse the tokens generated for this row by another model of the same source
+    if (sourceData_) {
+        forms = AllTokens;
+        if (sourceData_->findTokens(sourceRow, tokenConfiguration_, forms, &rv)) {
+            return rv;
+        }
+    }
 
     if (roles_.empty() && !roleNames_.empty()) {
         for (auto it = roleNames_.cbegin(), end = roleNames_.cend(); it != end; ++it) {
@@ -535,75 +1192,292 @@ std::unique_ptr<SearchModel::TokenList> SearchModel::searchTokens(int sourceRow)
         }
     }
 
-    TokenList tokens;
+    QList<QStringList> values;
     for (auto it = roles_.cbegin(), end = roles_.cend(); it != end; ++it) {
-        appendTokens(&tokens, getSourceValue(sourceRow, *it));
+        values.append(toStringList(getSourceValue(sourceRow, *it)));
     }
     for (auto it = properties_.cbegin(), end = properties_.cend(); it != end; ++it) {
-        appendTokens(&tokens, getSourceValue(sourceRow, *it));
+        values.append(toStringList(getSourceValue(sourceRow, *it)));
     }
 
-    auto copySorted = [](std::vector<const QString *> &src, std::vector<const QString *> &dst) {
-        std::sort(src.begin(), src.end(), LessThanIndirect());
-        src.erase(std::unique(src.begin(), src.end(), EqualIndirect()), src.end());
+    // Reuse the persisted tokens for this row, if its content is unchanged
+    quint64 key = 0;
+    quint64 content = 0;
+    bool cacheable = false;
+    if (tokenCache_ && forms == AllTokens) {
+        if (tokenCacheRole_ == -2) {
+            tokenCacheRole_ = findRole(tokenCacheKeyRole_);
+        }
+        if (tokenCacheRole_ != -1) {
+            const QVariant keyValue(getSourceValue(sourceRow, tokenCacheRole_));
+            if (keyValue.isValid()) {
+                cacheable = true;
+                key = hashString(HashBasis, keyValue.toString());
+                content = hashValues(values);
+                if (tokenCache_->find(key, content, &rv)) {
+                    if (sourceData_) {
+                        sourceData_->insertTokens(sourceRow, tokenConfiguration_, forms, rv);
+                    }
+                    return rv;
+                }
+            }
+        }
+    }
 
-        dst.reserve(src.size());
-        std::copy(src.cbegin(), src.cend(), std::back_inserter(dst));
-    };
-    if (!tokens.first.empty()) {
-        copySorted(tokens.first, rv->first);
+    TokenList tokens;
+    int position = 0;
+    for (const QStringList &value : values) {
+        appendTokens(&tokens, value, forms, &position);
+    }
+
+    if (!tokens.first.text.empty()) {
+        copySorted(tokens.first, &rv.first);
+    }
+    if (!tokens.second.text.empty()) {
+        copySorted(tokens.second, &rv.second);
+    }
+
+    if (cacheable) {
+        tokenCache_->insert(key, content, rv);
     }
-    if (!tokens.second.empty()) {
-        copySorted(tokens.second, rv->second);
+    if (sourceData_) {
+        sourceData_->insertTokens(sourceRow, tokenConfiguration_, forms, rv);
     }
 
-    return std::unique_ptr<TokenList>(rv);
+    return rv;
 }
 
 void SearchModel::searchTokensInvalidated()
 {
-    std::fill(tokens_.begin(), tokens_.end(), std::shared_ptr<TokenList>());
+    TokenSpan empty = { 0, 0, 0, 0 };
+    std::fill(tokenSpans_.begin(), tokenSpans_.end(), empty);
+    tokenIds_.clear();
+    tokenPositions_.clear();
+    unusedTokens_ = 0;
+    tokenizedRows_ = 0;
+
+    partMatchesInvalidated();
+    schedulePretokenization(0);
+}
+
+int SearchModel::tokenForms() const
+{
+    // The persistent cache, and the tokens shared with other models, require both forms for each row
+    if (allTokenForms_ || tokenCache_ || sourceData_) {
+        return AllTokens;
+    }
+    return sensitivity_ == Qt::CaseInsensitive ? LoweredTokens : CaseSensitiveTokens;
+}
+
+bool SearchModel::hasTokens(int sourceRow, int forms) const
+{
+    return (tokenSpans_.at(sourceRow).forms & forms) == forms;
+}
+
+void SearchModel::storeTokens(int sourceRow, const TokenList &tokens, int forms) const
+{
+    // Retain any form previously generated for this row that is not being replaced
+    const TokenSpan previous(tokenSpans_.at(sourceRow));
+    const int retainedForms(previous.forms & ~forms);
+
+    TokenList retained;
+    if (retainedForms & CaseSensitiveTokens) {
+        retained.first.text.assign(tokenIds_.cbegin() + previous.offset, tokenIds_.cbegin() + (previous.offset + previous.count));
+        retained.first.position.assign(tokenPositions_.cbegin() + previous.offset, tokenPositions_.cbegin() + (previous.offset + previous.count));
+    }
+    if (retainedForms & LoweredTokens) {
+        const quint32 offset(previous.offset + previous.count);
+        retained.second.text.assign(tokenIds_.cbegin() + offset, tokenIds_.cbegin() + (offset + previous.loweredCount));
+        retained.second.position.assign(tokenPositions_.cbegin() + offset, tokenPositions_.cbegin() + (offset + previous.loweredCount));
+    }
+
+    releaseTokens(sourceRow, 1);
+
+    // Reclaim the space of discarded tokens, once it dominates the arena
+    if (unusedTokens_ > 1024 && unusedTokens_ > tokenIds_.size() / 2) {
+        compactTokens();
+    }
+
+    const Tokens &cased((forms & CaseSensitiveTokens) ? tokens.first : retained.first);
+    const Tokens &lowered((forms & LoweredTokens) ? tokens.second : retained.second);
+
+    TokenSpan &span(tokenSpans_[sourceRow]);
+    span.offset = static_cast<quint32>(tokenIds_.size());
+    span.count = static_cast<quint32>(cased.text.size());
+    span.loweredCount = static_cast<quint32>(lowered.text.size());
+    span.forms = forms | retainedForms;
+    if (tokenizedForms_ && (span.forms & tokenizedForms_) == tokenizedForms_) {
+        ++tokenizedRows_;
+    }
+
+    tokenIds_.insert(tokenIds_.end(), cased.text.cbegin(), cased.text.cend());
+    tokenIds_.insert(tokenIds_.end(), lowered.text.cbegin(), lowered.text.cend());
+    tokenPositions_.insert(tokenPositions_.end(), cased.position.cbegin(), cased.position.cend());
+    tokenPositions_.insert(tokenPositions_.end(), lowered.position.cbegin(), lowered.position.cend());
+}
+
+void SearchModel::releaseTokens(int sourceRow, int count) const
+{
+    for (auto it = tokenSpans_.begin() + sourceRow, end = it + count; it != end; ++it) {
+        if (it->forms) {
+            if (tokenizedForms_ && (it->forms & tokenizedForms_) == tokenizedForms_) {
+                --tokenizedRows_;
+            }
+            unusedTokens_ += it->count + it->loweredCount;
+            it->offset = 0;
+            it->count = 0;
+            it->loweredCount = 0;
+            it->forms = 0;
+        }
+    }
+}
+
+void SearchModel::compactTokens() const
+{
+    std::vector<quint32> ids;
+    std::vector<quint8> positions;
+    ids.reserve(tokenIds_.size() - unusedTokens_);
+    positions.reserve(tokenIds_.size() - unusedTokens_);
+
+    for (TokenSpan &span : tokenSpans_) {
+        if (span.forms) {
+            const quint32 offset(static_cast<quint32>(ids.size()));
+            const quint32 count(span.count + span.loweredCount);
+            ids.insert(ids.end(), tokenIds_.cbegin() + span.offset, tokenIds_.cbegin() + (span.offset + count));
+            positions.insert(positions.end(), tokenPositions_.cbegin() + span.offset, tokenPositions_.cbegin() + (span.offset + count));
+            span.offset = offset;
+        }
+    }
+
+    tokenIds_.swap(ids);
+    tokenPositions_.swap(positions);
+    unusedTokens_ = 0;
+}
+
+void SearchModel::markTokens(std::vector<bool> *live) const
+{
+    // The unused portion of the arena is not marked
+    for (const TokenSpan &span : tokenSpans_) {
+        if (span.forms) {
+            for (auto it = tokenIds_.cbegin() + span.offset, end = it + (span.count + span.loweredCount); it != end; ++it) {
+                (*live)[*it] = true;
+            }
+        }
+    }
+    for (const QHash<quint32, int> &distances : distances_) {
+        for (auto it = distances.cbegin(), end = distances.cend(); it != end; ++it) {
+            (*live)[it.key()] = true;
+        }
+    }
+    if (tokenCache_) {
+        tokenCache_->markTokens(live);
+    }
+}
+
+void SearchModel::updatePartMatches()
+{
+    // Retain the results for any part that remains in the pattern
+    std::vector<PartMatches> previous;
+    previous.swap(partMatches_);
+
+    partMatches_.reserve(patternWords_.count());
+    for (const QString &word : patternWords_) {
+        auto it = std::find_if(previous.begin(), previous.end(), [&word](const PartMatches &matches) { return matches.word == word; });
+        if (it != previous.end()) {
+            partMatches_.push_back(std::move(*it));
+            previous.erase(it);
+        } else {
+            PartMatches matches;
+            matches.word = word;
+            matches.results.assign(tokenSpans_.size(), UnknownMatch);
+            partMatches_.push_back(std::move(matches));
+        }
+    }
+}
+
+void SearchModel::partMatchesInvalidated()
+{
+    for (PartMatches &matches : partMatches_) {
+        std::fill(matches.results.begin(), matches.results.end(), UnknownMatch);
+    }
 }
 
 void SearchModel::setModel(QAbstractItemModel *model)
 {
+    // Persist the tokens of the previous model before its rows are discarded
+    closeTokenCache();
+
     roles_.clear();
     properties_.clear();
+    tokenCacheRole_ = -2;
+    openTokenCache();
 
     BaseFilterModel::setModel(model);
 }
 
 void SearchModel::sourceItemsInserted(int insertIndex, int insertCount)
 {
-    tokens_.reserve(tokens_.size() + insertCount);
-    tokens_.insert(tokens_.begin() + insertIndex, insertCount, std::shared_ptr<TokenList>());
+    TokenSpan empty = { 0, 0, 0, 0 };
+    tokenSpans_.insert(tokenSpans_.begin() + insertIndex, insertCount, empty);
+    scores_.insert(scores_.begin() + insertIndex, insertCount, 0);
+    for (PartMatches &matches : partMatches_) {
+        matches.results.insert(matches.results.begin() + insertIndex, insertCount, UnknownMatch);
+    }
+
+    schedulePretokenization(insertIndex);
 }
 
 void SearchModel::sourceItemsMoved(int moveIndex, int moveCount, int insertIndex)
 {
-    std::vector<std::shared_ptr<TokenList>> movedItems;
-    movedItems.reserve(moveCount);
-
-    auto first = tokens_.begin() + moveIndex;
-    auto last = first + moveCount;
-    std::copy(first, last, std::back_inserter(movedItems));
+    // The insertion index is specified relative to the items before the move
+    const int destination(insertIndex > moveIndex ? insertIndex - moveCount : insertIndex);
+
+    // The tokens themselves are not moved within the arena
+    moveElements(&tokenSpans_, moveIndex, moveCount, destination);
+    moveElements(&scores_, moveIndex, moveCount, destination);
+    for (PartMatches &matches : partMatches_) {
+        moveElements(&matches.results, moveIndex, moveCount, destination);
+    }
 
-    tokens_.erase(first, last);
-    tokens_.insert(tokens_.begin() + insertIndex, movedItems.begin(), movedItems.end());
+    schedulePretokenization(qMin(moveIndex, destination));
 }
 
 void SearchModel::sourceItemsRemoved(int removeIndex, int removeCount)
 {
-    tokens_.erase(tokens_.begin() + removeIndex, tokens_.begin() + (removeIndex + removeCount));
+    releaseTokens(removeIndex, removeCount);
+    tokenSpans_.erase(tokenSpans_.begin() + removeIndex, tokenSpans_.begin() + (removeIndex + removeCount));
+    scores_.erase(scores_.begin() + removeIndex, scores_.begin() + (removeIndex + removeCount));
+    for (PartMatches &matches : partMatches_) {
+        matches.results.erase(matches.results.begin() + removeIndex, matches.results.begin() + (removeIndex + removeCount));
+    }
+
+    schedulePretokenization(removeIndex);
 }
 
 void SearchModel::sourceItemsChanged(int changeIndex, int changeCount)
 {
-    std::fill(tokens_.begin() + changeIndex, tokens_.begin() + (changeIndex + changeCount), std::shared_ptr<TokenList>());
+    releaseTokens(changeIndex, changeCount);
+    for (PartMatches &matches : partMatches_) {
+        std::fill(matches.results.begin() + changeIndex, matches.results.begin() + (changeIndex + changeCount), UnknownMatch);
+    }
+
+    schedulePretokenization(changeIndex);
 }
 
 void SearchModel::sourceItemsCleared()
 {
-    tokens_.clear();
+    tokenSpans_.clear();
+    tokenIds_.clear();
+    tokenPositions_.clear();
+    unusedTokens_ = 0;
+    tokenizedRows_ = 0;
+    scores_.clear();
+    for (PartMatches &matches : partMatches_) {
+        matches.results.clear();
+    }
+
+    pretokenizeRow_ = 0;
+    pretokenizeTimer_.stop();
+    updateTokenizationProgress();
 }
 
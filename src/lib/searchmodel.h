@@ -36,12 +36,16 @@
 #include <nemomodels.h>
 #include "basefiltermodel.h"
 
+#include <QHash>
 #include <QList>
 #include <QMetaMethod>
+#include <QTimer>
 
 #include <memory>
 #include <vector>
 
+class SearchTokenCache;
+
 class NEMO_QML_PLUGIN_MODELS_EXPORT SearchModel : public BaseFilterModel
 {
     Q_OBJECT
@@ -50,17 +54,37 @@ class NEMO_QML_PLUGIN_MODELS_EXPORT SearchModel : public BaseFilterModel
     Q_PROPERTY(QString pattern READ pattern WRITE setPattern NOTIFY patternChanged)
     Q_PROPERTY(Qt::CaseSensitivity caseSensitivity READ caseSensitivity WRITE setCaseSensitivity NOTIFY caseSensitivityChanged)
     Q_PROPERTY(MatchType matchType READ matchType WRITE setMatchType NOTIFY matchTypeChanged)
+    Q_PROPERTY(int maximumEditDistance READ maximumEditDistance WRITE setMaximumEditDistance NOTIFY maximumEditDistanceChanged)
+    Q_PROPERTY(bool sortByRelevance READ sortByRelevance WRITE setSortByRelevance NOTIFY sortByRelevanceChanged)
+    Q_PROPERTY(QString tokenCacheFile READ tokenCacheFile WRITE setTokenCacheFile NOTIFY tokenCacheFileChanged)
+    Q_PROPERTY(QString tokenCacheKeyRole READ tokenCacheKeyRole WRITE setTokenCacheKeyRole NOTIFY tokenCacheKeyRoleChanged)
+    Q_PROPERTY(bool pretokenize READ pretokenize WRITE setPretokenize NOTIFY pretokenizeChanged)
+    Q_PROPERTY(qreal tokenizationProgress READ tokenizationProgress NOTIFY tokenizationProgressChanged)
     Q_ENUMS(MatchType)
 
 public:
     enum MatchType {
         MatchBeginning,
-        MatchAnywhere
+        MatchAnywhere,
+        MatchFuzzy
+    };
+
+    // Token text is identified by its index in the shared token pool
+    struct Tokens {
+        std::vector<quint32> text;
+        std::vector<quint8> position;
     };
+    typedef std::pair<Tokens, Tokens> TokenList;
 
-    typedef std::pair<std::vector<const QString *>, std::vector<const QString *>> TokenList;
+    // The forms in which tokens are generated for a row
+    enum TokenForm {
+        CaseSensitiveTokens = 0x1,
+        LoweredTokens = 0x2,
+        AllTokens = CaseSensitiveTokens | LoweredTokens
+    };
 
     explicit SearchModel(QObject *parent = 0);
+    ~SearchModel();
 
     void setSearchRoles(const QStringList &roles);
     QStringList searchRoles() const;
@@ -77,20 +101,67 @@ public:
     void setMatchType(MatchType type);
     MatchType matchType() const;
 
+    void setMaximumEditDistance(int distance);
+    int maximumEditDistance() const;
+
+    void setSortByRelevance(bool enabled);
+    bool sortByRelevance() const;
+
+    void setTokenCacheFile(const QString &fileName);
+    QString tokenCacheFile() const;
+
+    void setTokenCacheKeyRole(const QString &roleName);
+    QString tokenCacheKeyRole() const;
+
+    Q_INVOKABLE bool saveTokenCache();
+
+    void setPretokenize(bool enabled);
+    bool pretokenize() const;
+
+    qreal tokenizationProgress() const;
+
 signals:
     void searchRolesChanged();
     void searchPropertiesChanged();
     void patternChanged();
     void caseSensitivityChanged();
     void matchTypeChanged();
+    void maximumEditDistanceChanged();
+    void sortByRelevanceChanged();
+    void tokenCacheFileChanged();
+    void tokenCacheKeyRoleChanged();
+    void pretokenizeChanged();
+    void tokenizationProgressChanged();
+
+private slots:
+    void pretokenizeItems();
 
 protected:
     bool filtered() const override;
     bool includeItem(int sourceRow) const override;
 
-    std::unique_ptr<TokenList> searchTokens(int sourceRow) const;
+    bool ranked() const override;
+    bool lessThan(int lhsSourceRow, int rhsSourceRow) const override;
+
+    TokenList searchTokens(int sourceRow, int forms) const;
     void searchTokensInvalidated();
 
+    int tokenForms() const;
+    bool hasTokens(int sourceRow, int forms) const;
+    void storeTokens(int sourceRow, const TokenList &tokens, int forms) const;
+    void releaseTokens(int sourceRow, int count) const;
+    void compactTokens() const;
+    void markTokens(std::vector<bool> *live) const;
+
+    void updatePartMatches();
+    void partMatchesInvalidated();
+
+    void openTokenCache();
+    void closeTokenCache();
+
+    void schedulePretokenization(int sourceRow);
+    void updateTokenizationProgress();
+
     void setModel(QAbstractItemModel *model) override;
 
     void sourceItemsInserted(int insertIndex, int insertCount) override;
@@ -104,12 +175,54 @@ protected:
     QString pattern_;
     Qt::CaseSensitivity sensitivity_;
     MatchType matchType_;
+    int maximumDistance_;
+    bool sortByRelevance_;
+    bool allTokenForms_;
+    QString tokenCacheFile_;
+    QString tokenCacheKeyRole_;
+    // Identifies the tokens of this configuration among those shared for the source
+    QString tokenConfiguration_;
+    bool pretokenize_;
 
     mutable std::vector<int> roles_;
     mutable std::vector<QMetaProperty> properties_;
+    QStringList patternWords_;
     mutable QList<QStringList> patterns_;
+    mutable QHash<QString, QHash<quint32, int>> distances_;
+
+    // The tokens of each row are stored contiguously, with the case sensitive tokens
+    // followed by the lowered tokens.  Only the forms generated are present.
+    struct TokenSpan {
+        quint32 offset;
+        quint32 count;
+        quint32 loweredCount;
+        quint32 forms;
+    };
+
+    mutable std::vector<TokenSpan> tokenSpans_;
+    mutable std::vector<quint32> tokenIds_;
+    mutable std::vector<quint8> tokenPositions_;
+    mutable size_t unusedTokens_;
+    mutable std::vector<int> scores_;
+
+    // The result of matching each part of the pattern against each row, retained while the
+    // part remains in the pattern
+    struct PartMatches {
+        QString word;
+        std::vector<quint16> results;
+    };
+
+    mutable std::vector<PartMatches> partMatches_;
+
+    std::unique_ptr<SearchTokenCache> tokenCache_;
+    mutable int tokenCacheRole_;
 
-    mutable std::vector<std::shared_ptr<TokenList>> tokens_;
+    QTimer pretokenizeTimer_;
+    int pretokenizeRow_;
+    // The number of rows holding each of the token forms in tokenizedForms_
+    mutable int tokenizedRows_;
+    int tokenizedForms_;
+    qreal tokenizationProgress_;
 };
 
 #endif // SEARCHMODEL_H
@@ -0,0 +1,391 @@
+/*
+ * Copyright (C) 2026 nemo-qml-plugin-models contributors
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "searchtokencache.h"
+#include "searchtokenpool.h"
+
+#include <QSaveFile>
+
+#include <QtDebug>
+
+#include <algorithm>
+
+namespace {
+
+const quint32 CacheMagic = 0x4354454e; // 'NETC'
+const quint32 CacheVersion = 1;
+
+const quint32 Unresolved = 0xffffffff;
+
+template<typename T>
+void writeItems(QIODevice *device, const T *items, size_t count)
+{
+    if (count) {
+        device->write(reinterpret_cast<const char *>(items), static_cast<qint64>(count * sizeof(T)));
+    }
+}
+
+}
+
+SearchTokenCache::SearchTokenCache(const QString &fileName, quint64 configuration)
+    : fileName_(fileName)
+    , configuration_(configuration)
+    , file_(fileName)
+    , data_(0)
+    , header_(0)
+    , entries_(0)
+    , tokens_(0)
+    , ids_(0)
+    , strings_(0)
+    , positions_(0)
+    , generation_(0)
+{
+    open();
+}
+
+SearchTokenCache::~SearchTokenCache()
+{
+    close();
+}
+
+void SearchTokenCache::open()
+{
+    if (!file_.exists() || !file_.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    const qint64 size(file_.size());
+    if (size >= static_cast<qint64>(sizeof(Header))) {
+        data_ = file_.map(0, size);
+    }
+    if (!data_) {
+        file_.close();
+        return;
+    }
+
+    const Header *header = reinterpret_cast<const Header *>(data_);
+    if (header->magic != CacheMagic || header->version != CacheVersion || header->configuration != configuration_) {
+        // Produced by a different configuration; this content will be replaced when saved
+        close();
+        return;
+    }
+
+    const qint64 expectedSize(sizeof(Header)
+                              + static_cast<qint64>(header->entryCount) * sizeof(Entry)
+                              + static_cast<qint64>(header->tokenCount) * sizeof(Token)
+                              + static_cast<qint64>(header->idCount) * (sizeof(quint32) + sizeof(quint8))
+                              + static_cast<qint64>(header->stringLength) * sizeof(QChar));
+    if (expectedSize != size) {
+        qWarning() << "Ignoring invalid search token cache:" << fileName_;
+        close();
+        return;
+    }
+
+    const uchar *position = data_ + sizeof(Header);
+    entries_ = reinterpret_cast<const Entry *>(position);
+    position += header->entryCount * sizeof(Entry);
+    tokens_ = reinterpret_cast<const Token *>(position);
+    position += header->tokenCount * sizeof(Token);
+    ids_ = reinterpret_cast<const quint32 *>(position);
+    position += header->idCount * sizeof(quint32);
+    strings_ = reinterpret_cast<const QChar *>(position);
+    position += header->stringLength * sizeof(QChar);
+    positions_ = reinterpret_cast<const quint8 *>(position);
+
+    // Reject any references outside the extent of the file
+    for (quint32 i = 0; i < header->tokenCount; ++i) {
+        const Token &token(tokens_[i]);
+        if (token.offset > header->stringLength || token.length > header->stringLength - token.offset) {
+            qWarning() << "Ignoring invalid search token cache:" << fileName_;
+            close();
+            return;
+        }
+    }
+    for (quint32 i = 0; i < header->entryCount; ++i) {
+        const Entry &entry(entries_[i]);
+        const quint64 count(static_cast<quint64>(entry.count) + entry.loweredCount);
+        if (entry.firstId > header->idCount || count > header->idCount - entry.firstId) {
+            qWarning() << "Ignoring invalid search token cache:" << fileName_;
+            close();
+            return;
+        }
+    }
+    for (quint32 i = 0; i < header->idCount; ++i) {
+        if (ids_[i] >= header->tokenCount) {
+            qWarning() << "Ignoring invalid search token cache:" << fileName_;
+            close();
+            return;
+        }
+    }
+
+    header_ = header;
+    resolved_.assign(header->tokenCount, Unresolved);
+}
+
+void SearchTokenCache::close()
+{
+    if (data_) {
+        file_.unmap(data_);
+        data_ = 0;
+    }
+    if (file_.isOpen()) {
+        file_.close();
+    }
+
+    header_ = 0;
+    entries_ = 0;
+    tokens_ = 0;
+    ids_ = 0;
+    strings_ = 0;
+    positions_ = 0;
+    resolved_.clear();
+}
+
+const SearchTokenCache::Entry *SearchTokenCache::findEntry(quint64 key) const
+{
+    if (!header_) {
+        return 0;
+    }
+
+    const Entry *end = entries_ + header_->entryCount;
+    const Entry *it = std::lower_bound(entries_, end, key, [](const Entry &entry, quint64 key) { return entry.key < key; });
+    return (it != end && it->key == key) ? it : 0;
+}
+
+quint32 SearchTokenCache::resolveToken(quint32 id)
+{
+    SearchTokenPool *pool = SearchTokenPool::instance();
+    if (generation_ != pool->generation()) {
+        // The resolved indices may have been released from the pool
+        std::fill(resolved_.begin(), resolved_.end(), Unresolved);
+        generation_ = pool->generation();
+    }
+
+    quint32 &rv(resolved_[id]);
+    if (rv == Unresolved) {
+        const Token &token(tokens_[id]);
+        rv = pool->intern(strings_ + token.offset, static_cast<int>(token.length));
+    }
+    return rv;
+}
+
+void SearchTokenCache::resolve(const Entry &entry, SearchModel::TokenList *tokens)
+{
+    const quint32 *ids = ids_ + entry.firstId;
+    const quint8 *positions = positions_ + entry.firstId;
+
+    tokens->first.text.reserve(entry.count);
+    tokens->first.position.assign(positions, positions + entry.count);
+    for (quint32 i = 0; i < entry.count; ++i) {
+        tokens->first.text.push_back(resolveToken(ids[i]));
+    }
+
+    ids += entry.count;
+    positions += entry.count;
+
+    tokens->second.text.reserve(entry.loweredCount);
+    tokens->second.position.assign(positions, positions + entry.loweredCount);
+    for (quint32 i = 0; i < entry.loweredCount; ++i) {
+        tokens->second.text.push_back(resolveToken(ids[i]));
+    }
+}
+
+bool SearchTokenCache::find(quint64 key, quint64 content, SearchModel::TokenList *tokens)
+{
+    auto rit = records_.constFind(key);
+    if (rit != records_.constEnd()) {
+        if (rit->content != content) {
+            return false;
+        }
+        *tokens = rit->tokens;
+        return true;
+    }
+
+    const Entry *entry = findEntry(key);
+    if (!entry || entry->content != content) {
+        return false;
+    }
+
+    resolve(*entry, tokens);
+    used_.insert(key);
+    return true;
+}
+
+void SearchTokenCache::insert(quint64 key, quint64 content, const SearchModel::TokenList &tokens)
+{
+    Record &record(records_[key]);
+    record.content = content;
+    record.tokens = tokens;
+}
+
+bool SearchTokenCache::modified() const
+{
+    return !records_.isEmpty();
+}
+
+void SearchTokenCache::markTokens(std::vector<bool> *live) const
+{
+    // Tokens resolved from the file are interned again if their indices are released
+    for (const Record &record : records_) {
+        SearchTokenPool::mark(record.tokens.first.text, live);
+        SearchTokenPool::mark(record.tokens.second.text, live);
+    }
+}
+
+bool SearchTokenCache::save(bool complete)
+{
+    if (records_.isEmpty()) {
+        return true;
+    }
+
+    typedef std::pair<quint64, const Record *> Item;
+
+    // Retain entries from the existing file unless they have been superseded.  If every row
+    // of the model has been tokenized, entries not used by any row are discarded
+    auto retain = [this, complete](quint64 key) {
+        return !records_.contains(key) && (!complete || used_.contains(key));
+    };
+
+    std::vector<Item> items;
+    items.reserve(records_.count());
+    for (auto it = records_.cbegin(), end = records_.cend(); it != end; ++it) {
+        items.push_back(std::make_pair(it.key(), &it.value()));
+    }
+    std::sort(items.begin(), items.end(), [](const Item &lhs, const Item &rhs) { return lhs.first < rhs.first; });
+
+    // Each distinct token string is stored once, and referenced by index.  Retained entries are
+    // copied from the mapped file, without being interned in the pool
+    const SearchTokenPool *pool = SearchTokenPool::instance();
+    QHash<QString, quint32> tokenIds;
+    std::vector<Entry> entries;
+    std::vector<Token> tokens;
+    std::vector<quint32> ids;
+    std::vector<quint8> positions;
+    QString strings;
+
+    auto appendToken = [&](const QChar *text, int length, quint8 position) {
+        // The key refers to text in the pool or the mapped file, both unchanged until written
+        const QString key(QString::fromRawData(text, length));
+        auto tit = tokenIds.constFind(key);
+        if (tit == tokenIds.constEnd()) {
+            Token token;
+            token.offset = strings.length();
+            token.length = length;
+            strings.append(text, length);
+            tit = tokenIds.insert(key, static_cast<quint32>(tokens.size()));
+            tokens.push_back(token);
+        }
+        ids.push_back(*tit);
+        positions.push_back(position);
+    };
+
+    auto appendEntry = [&](quint64 key, quint64 content, quint32 count, quint32 loweredCount) {
+        Entry entry;
+        entry.key = key;
+        entry.content = content;
+        entry.firstId = static_cast<quint32>(ids.size());
+        entry.count = count;
+        entry.loweredCount = loweredCount;
+        entry.reserved = 0;
+        entries.push_back(entry);
+    };
+
+    auto appendRecord = [&](const Item &item) {
+        const SearchModel::TokenList &list(item.second->tokens);
+        appendEntry(item.first, item.second->content, static_cast<quint32>(list.first.text.size()), static_cast<quint32>(list.second.text.size()));
+        for (size_t i = 0, n = list.first.text.size(); i < n; ++i) {
+            appendToken(pool->begin(list.first.text[i]), pool->length(list.first.text[i]), list.first.position[i]);
+        }
+        for (size_t i = 0, n = list.second.text.size(); i < n; ++i) {
+            appendToken(pool->begin(list.second.text[i]), pool->length(list.second.text[i]), list.second.position[i]);
+        }
+    };
+
+    auto appendRetained = [&](const Entry &retained) {
+        appendEntry(retained.key, retained.content, retained.count, retained.loweredCount);
+        for (quint32 i = retained.firstId, end = retained.firstId + retained.count + retained.loweredCount; i < end; ++i) {
+            const Token &token(tokens_[ids_[i]]);
+            appendToken(strings_ + token.offset, static_cast<int>(token.length), positions_[i]);
+        }
+    };
+
+    // Merge the retained entries with the new records, in key order
+    const Entry *eit = header_ ? entries_ : 0;
+    const Entry *eend = header_ ? entries_ + header_->entryCount : 0;
+    auto rit = items.cbegin();
+    while (eit != eend || rit != items.cend()) {
+        if (eit != eend && !retain(eit->key)) {
+            ++eit;
+        } else if (rit == items.cend() || (eit != eend && eit->key < rit->first)) {
+            appendRetained(*eit++);
+        } else {
+            appendRecord(*rit++);
+        }
+    }
+
+    Header header;
+    header.magic = CacheMagic;
+    header.version = CacheVersion;
+    header.configuration = configuration_;
+    header.entryCount = static_cast<quint32>(entries.size());
+    header.tokenCount = static_cast<quint32>(tokens.size());
+    header.idCount = static_cast<quint32>(ids.size());
+    header.stringLength = static_cast<quint32>(strings.length());
+
+    QSaveFile output(fileName_);
+    if (!output.open(QIODevice::WriteOnly)) {
+        qWarning() << "Unable to write search token cache:" << fileName_ << output.errorString();
+        return false;
+    }
+
+    writeItems(&output, &header, 1);
+    writeItems(&output, entries.data(), entries.size());
+    writeItems(&output, tokens.data(), tokens.size());
+    writeItems(&output, ids.data(), ids.size());
+    writeItems(&output, strings.constData(), static_cast<size_t>(strings.length()));
+    writeItems(&output, positions.data(), positions.size());
+
+    // Release the existing mapping before it is replaced
+    close();
+
+    const bool rv(output.commit());
+    if (!rv) {
+        qWarning() << "Unable to write search token cache:" << fileName_ << output.errorString();
+    } else {
+        for (auto it = records_.cbegin(), end = records_.cend(); it != end; ++it) {
+            used_.insert(it.key());
+        }
+        records_.clear();
+    }
+
+    open();
+    return rv;
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2026 nemo-qml-plugin-models contributors
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef SEARCHTOKENCACHE_H
+#define SEARCHTOKENCACHE_H
+
+#include "searchmodel.h"
+
+#include <QFile>
+#include <QHash>
+#include <QSet>
+#include <QString>
+
+#include <vector>
+
+// A persistent store of the tokens generated for the rows of a SearchModel.  Each row is
+// identified by a hash of a stable key supplied by the client, and is only reused while the
+// hash of the tokenized content remains unchanged.
+class SearchTokenCache
+{
+public:
+    SearchTokenCache(const QString &fileName, quint64 configuration);
+    ~SearchTokenCache();
+
+    bool find(quint64 key, quint64 content, SearchModel::TokenList *tokens);
+    void insert(quint64 key, quint64 content, const SearchModel::TokenList &tokens);
+
+    bool modified() const;
+    bool save(bool complete);
+
+    void markTokens(std::vector<bool> *live) const;
+
+private:
+    struct Header {
+        quint32 magic;
+        quint32 version;
+        quint64 configuration;
+        quint32 entryCount;
+        quint32 tokenCount;
+        quint32 idCount;
+        quint32 stringLength;
+    };
+
+    struct Entry {
+        quint64 key;
+        quint64 content;
+        quint32 firstId;
+        quint32 count;
+        quint32 loweredCount;
+        quint32 reserved;
+    };
+
+    struct Token {
+        quint32 offset;
+        quint32 length;
+    };
+
+    struct Record {
+        quint64 content;
+        SearchModel::TokenList tokens;
+    };
+
+    void open();
+    void close();
+
+    const Entry *findEntry(quint64 key) const;
+    void resolve(const Entry &entry, SearchModel::TokenList *tokens);
+    quint32 resolveToken(quint32 id);
+
+    QString fileName_;
+    quint64 configuration_;
+    QFile file_;
+    uchar *data_;
+    const Header *header_;
+    const Entry *entries_;
+    const Token *tokens_;
+    const quint32 *ids_;
+    const QChar *strings_;
+    const quint8 *positions_;
+    // The pool index of each token of the file, while the pool generation is unchanged
+    std::vector<quint32> resolved_;
+    quint32 generation_;
+    QHash<quint64, Record> records_;
+    QSet<quint64> used_;
+};
+
+#endif // SEARCHTOKENCACHE_H
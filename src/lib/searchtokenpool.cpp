@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2026 nemo-qml-plugin-models contributors
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "searchtokenpool.h"
+
+#include <QTimer>
+
+#include <algorithm>
+
+namespace {
+
+// Text is not reclaimed from a pool smaller than this
+const int MinimumCompactionLength = 16384;
+
+}
+
+SearchTokenPool::SearchTokenPool()
+    : retainedLength_(0)
+    , compactionPending_(false)
+    , generation_(0)
+{
+}
+
+SearchTokenPool *SearchTokenPool::instance()
+{
+    static SearchTokenPool pool;
+    return &pool;
+}
+
+void SearchTokenPool::acquire(const void *holder, const MarkFunction &mark)
+{
+    instance()->holders_.insert(holder, mark);
+}
+
+void SearchTokenPool::release(const void *holder)
+{
+    SearchTokenPool *pool(instance());
+    if (pool->holders_.remove(holder) && pool->holders_.isEmpty()) {
+        // No token indices remain in use
+        pool->clear();
+    }
+}
+
+void SearchTokenPool::mark(const std::vector<quint32> &ids, std::vector<bool> *live)
+{
+    for (quint32 id : ids) {
+        (*live)[id] = true;
+    }
+}
+
+quint32 SearchTokenPool::intern(const QChar *text, int length)
+{
+    const uint hashValue(qHash(QString::fromRawData(text, length)));
+
+    // Compare the content of each token with a matching hash, since distinct tokens may collide
+    const auto range(index_.equal_range(hashValue));
+    for (auto it = range.first; it != range.second; ++it) {
+        const quint32 id(it.value());
+        if (this->length(id) == length && std::equal(text, text + length, begin(id))) {
+            return id;
+        }
+    }
+
+    Entry entry;
+    entry.offset = static_cast<quint32>(text_.length());
+    entry.length = static_cast<quint32>(length);
+    text_.append(text, length);
+
+    quint32 rv;
+    if (!freeIds_.empty()) {
+        rv = freeIds_.back();
+        freeIds_.pop_back();
+        entries_[rv] = entry;
+    } else {
+        rv = static_cast<quint32>(entries_.size());
+        entries_.push_back(entry);
+    }
+    index_.insert(hashValue, rv);
+
+    // Tokens are only interned during tokenization, while their indices are not yet stored by
+    // any holder, so the pool is compacted from the event loop
+    if (!compactionPending_ && text_.length() > MinimumCompactionLength && text_.length() > 2 * retainedLength_) {
+        compactionPending_ = true;
+        QTimer::singleShot(0, []() { instance()->compact(); });
+    }
+
+    return rv;
+}
+
+bool SearchTokenPool::lessThan(quint32 lhs, quint32 rhs) const
+{
+    return std::lexicographical_compare(begin(lhs), end(lhs), begin(rhs), end(rhs));
+}
+
+void SearchTokenPool::clear()
+{
+    text_ = QString();
+    std::vector<Entry>().swap(entries_);
+    std::vector<quint32>().swap(freeIds_);
+    index_ = QMultiHash<uint, quint32>();
+    retainedLength_ = 0;
+    compactionPending_ = false;
+    ++generation_;
+}
+
+void SearchTokenPool::compact()
+{
+    if (!compactionPending_)
+        return;
+
+    compactionPending_ = false;
+
+    std::vector<bool> live(entries_.size(), false);
+    for (const MarkFunction &mark : holders_) {
+        mark(&live);
+    }
+
+    // Copy the text of the live tokens, and release the indices of the others
+    QString text;
+    freeIds_.clear();
+    for (quint32 id = 0, count = static_cast<quint32>(entries_.size()); id < count; ++id) {
+        Entry &entry(entries_[id]);
+        if (live[id]) {
+            const quint32 offset(static_cast<quint32>(text.length()));
+            text.append(text_.constData() + entry.offset, static_cast<int>(entry.length));
+            entry.offset = offset;
+        } else {
+            entry.offset = 0;
+            entry.length = 0;
+            freeIds_.push_back(id);
+        }
+    }
+    for (auto it = index_.begin(); it != index_.end(); ) {
+        if (live[it.value()]) {
+            ++it;
+        } else {
+            it = index_.erase(it);
+        }
+    }
+
+    text_ = text;
+    retainedLength_ = text_.length();
+    ++generation_;
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2026 nemo-qml-plugin-models contributors
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef SEARCHTOKENPOOL_H
+#define SEARCHTOKENPOOL_H
+
+#include <QHash>
+#include <QString>
+
+#include <functional>
+#include <vector>
+
+// Interned storage for search token text.  Each distinct token is stored once, in a single
+// buffer, and is identified by a 32-bit index.  Pointers to token text remain valid only
+// until the next token is interned, or the pool is compacted.
+//
+// Holders of token indices register with the pool.  Once more text has been interned than the
+// pool retained when last compacted, it is compacted when control returns to the event loop:
+// each holder marks the indices it still refers to, and the others are released for reuse.
+// Retained tokens keep their indices.  The pool is emptied once the last holder is released.
+// Either way its generation changes, so that indices cached elsewhere are discarded.
+class SearchTokenPool
+{
+public:
+    typedef std::function<void (std::vector<bool> *)> MarkFunction;
+
+    static SearchTokenPool *instance();
+
+    static void acquire(const void *holder, const MarkFunction &mark);
+    static void release(const void *holder);
+
+    static void mark(const std::vector<quint32> &ids, std::vector<bool> *live);
+
+    quint32 generation() const { return generation_; }
+
+    quint32 intern(const QChar *text, int length);
+    quint32 intern(const QString &token) { return intern(token.constData(), token.length()); }
+
+    const QChar *begin(quint32 id) const { return text_.constData() + entries_[id].offset; }
+    const QChar *end(quint32 id) const { return begin(id) + entries_[id].length; }
+    int length(quint32 id) const { return static_cast<int>(entries_[id].length); }
+    QString text(quint32 id) const { return QString(begin(id), length(id)); }
+
+    bool lessThan(quint32 lhs, quint32 rhs) const;
+
+private:
+    SearchTokenPool();
+
+    void clear();
+    void compact();
+
+    struct Entry {
+        quint32 offset;
+        quint32 length;
+    };
+
+    QString text_;
+    std::vector<Entry> entries_;
+    std::vector<quint32> freeIds_;
+    QMultiHash<uint, quint32> index_;
+    QHash<const void *, MarkFunction> holders_;
+    int retainedLength_;
+    bool compactionPending_;
+    quint32 generation_;
+};
+
+#endif // SEARCHTOKENPOOL_H
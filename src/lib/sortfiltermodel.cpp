@@ -13,6 +13,8 @@
 
 #include "sortfiltermodel.h"
 
+#include <vector>
+
 SortFilterModel::SortFilterModel(QObject *parent)
     : QSortFilterProxyModel(parent)
 {
@@ -199,15 +201,43 @@ void SortFilterModel::setSortColumn(int column)
     Q_EMIT sortColumnChanged();
 }
 
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+void SortFilterModel::multiData(const QModelIndex &index, QModelRoleDataSpan roleDataSpan) const
+{
+    if (!sourceModel() || !index.isValid()) {
+        for (QModelRoleData &roleData : roleDataSpan) {
+            roleData.clearData();
+        }
+        return;
+    }
+
+    sourceModel()->multiData(mapToSource(index), roleDataSpan);
+}
+#endif
+
 QVariantMap SortFilterModel::get(int row) const
 {
     QModelIndex idx = index(row, 0);
     QVariantMap hash;
 
     const QHash<int, QByteArray> rNames = roleNames();
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    std::vector<QModelRoleData> roleData;
+    roleData.reserve(rNames.count());
+    for (auto i = rNames.begin(); i != rNames.end(); ++i) {
+        roleData.emplace_back(i.key());
+    }
+    multiData(idx, QModelRoleDataSpan(roleData));
+
+    auto value = roleData.cbegin();
+    for (auto i = rNames.begin(); i != rNames.end(); ++i, ++value) {
+        hash[QString::fromUtf8(i.value())] = value->data();
+    }
+#else
     for (auto i = rNames.begin(); i != rNames.end(); ++i) {
         hash[QString::fromUtf8(i.value())] = data(idx, i.key());
     }
+#endif
 
     return hash;
 }
@@ -129,6 +129,9 @@ protected:
     int roleNameToId(const QString &name) const;
     bool filterAcceptsRow(int source_row, const QModelIndex &source_parent) const override;
     QHash<int, QByteArray> roleNames() const override;
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    void multiData(const QModelIndex &index, QModelRoleDataSpan roleDataSpan) const override;
+#endif
 
 protected Q_SLOTS:
     void syncRoleNames();
@@ -0,0 +1,279 @@
+/*
+ * Copyright (C) 2026 nemo-qml-plugin-models contributors
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "sourcedata.h"
+#include "searchtokenpool.h"
+
+#include <algorithm>
+
+namespace {
+
+// The shared data of each source model, while any filter model uses it
+QHash<const QAbstractItemModel *, std::weak_ptr<SourceData>> &sharedData()
+{
+    static QHash<const QAbstractItemModel *, std::weak_ptr<SourceData>> data;
+    return data;
+}
+
+template<typename T>
+void insertRows(std::vector<T> *rows, int first, int count)
+{
+    if (first <= int(rows->size())) {
+        rows->insert(rows->begin() + first, count, T());
+    }
+}
+
+template<typename T>
+void moveRows(std::vector<T> *rows, int first, int count, int destination)
+{
+    if (first + count > int(rows->size()) || destination + count > int(rows->size()))
+        return;
+
+    if (destination < first) {
+        std::rotate(rows->begin() + destination, rows->begin() + first, rows->begin() + first + count);
+    } else {
+        std::rotate(rows->begin() + first, rows->begin() + first + count, rows->begin() + destination + count);
+    }
+}
+
+template<typename T>
+void removeRows(std::vector<T> *rows, int first, int count)
+{
+    if (first + count <= int(rows->size())) {
+        rows->erase(rows->begin() + first, rows->begin() + first + count);
+    }
+}
+
+template<typename T>
+void clearRows(std::vector<T> *rows, int first, int last)
+{
+    for (int row = first, end = std::min<int>(last + 1, rows->size()); row < end; ++row) {
+        (*rows)[row] = T();
+    }
+}
+
+}
+
+SourceData::SourceData(QAbstractItemModel *model)
+    : QObject(0)
+    , model_(model)
+{
+    // Rows are inserted, moved and removed before the source reports the change, so that the
+    // shared data is already consistent when any of its users handle the change
+    connect(model_, &QAbstractItemModel::rowsAboutToBeInserted, this, &SourceData::sourceRowsAboutToBeInserted);
+    connect(model_, &QAbstractItemModel::rowsAboutToBeMoved, this, &SourceData::sourceRowsAboutToBeMoved);
+    connect(model_, &QAbstractItemModel::rowsAboutToBeRemoved, this, &SourceData::sourceRowsAboutToBeRemoved);
+    connect(model_, &QAbstractItemModel::modelAboutToBeReset, this, &SourceData::sourceCleared);
+    connect(model_, &QAbstractItemModel::layoutAboutToBeChanged, this, &SourceData::sourceCleared);
+    connect(model_, &QAbstractItemModel::dataChanged, this, &SourceData::sourceDataChanged);
+    connect(model_, &QObject::destroyed, this, &SourceData::sourceDestroyed);
+}
+
+SourceData::~SourceData()
+{
+    if (model_) {
+        sharedData().remove(model_);
+    }
+    if (!tokens_.isEmpty()) {
+        SearchTokenPool::release(this);
+    }
+}
+
+std::shared_ptr<SourceData> SourceData::attach(QAbstractItemModel *model)
+{
+    std::shared_ptr<SourceData> rv(sharedData().value(model).lock());
+    if (!rv) {
+        rv.reset(new SourceData(model));
+        sharedData().insert(model, rv);
+    }
+    return rv;
+}
+
+bool SourceData::findValue(int row, int role, QVariant *value) const
+{
+    auto it = values_.constFind(role);
+    if (it == values_.constEnd() || row < 0 || row >= int(it->size()))
+        return false;
+
+    const Value &cached((*it)[row]);
+    if (!cached.valid)
+        return false;
+
+    *value = cached.value;
+    return true;
+}
+
+void SourceData::insertValue(int row, int role, const QVariant &value)
+{
+    if (!model_)
+        return;
+
+    auto it = values_.find(role);
+    if (it == values_.end()) {
+        it = values_.insert(role, std::vector<Value>(model_->rowCount()));
+    }
+    if (row >= 0 && row < int(it->size())) {
+        Value &cached((*it)[row]);
+        cached.value = value;
+        cached.valid = true;
+    }
+}
+
+bool SourceData::findTokens(int row, const QString &configuration, int forms, SearchModel::TokenList *tokens) const
+{
+    auto it = tokens_.constFind(configuration);
+    if (it == tokens_.constEnd() || row < 0 || row >= int(it->size()))
+        return false;
+
+    const Tokens &cached((*it)[row]);
+    if ((cached.forms & forms) != forms)
+        return false;
+
+    *tokens = cached.tokens;
+    return true;
+}
+
+void SourceData::insertTokens(int row, const QString &configuration, int forms, const SearchModel::TokenList &tokens)
+{
+    if (!model_)
+        return;
+
+    auto it = tokens_.find(configuration);
+    if (it == tokens_.end()) {
+        if (tokens_.isEmpty()) {
+            // The stored tokens refer to the pool
+            SearchTokenPool::acquire(this, [this](std::vector<bool> *live) { markTokens(live); });
+        }
+        it = tokens_.insert(configuration, std::vector<Tokens>(model_->rowCount()));
+    }
+    if (row >= 0 && row < int(it->size())) {
+        Tokens &cached((*it)[row]);
+        cached.tokens = tokens;
+        cached.forms = forms;
+    }
+}
+
+void SourceData::markTokens(std::vector<bool> *live) const
+{
+    for (const std::vector<Tokens> &rows : tokens_) {
+        for (const Tokens &cached : rows) {
+            SearchTokenPool::mark(cached.tokens.first.text, live);
+            SearchTokenPool::mark(cached.tokens.second.text, live);
+        }
+    }
+}
+
+void SourceData::sourceRowsAboutToBeInserted(const QModelIndex &parent, int first, int last)
+{
+    if (parent.isValid())
+        return;
+
+    for (std::vector<Value> &rows : values_) {
+        insertRows(&rows, first, last - first + 1);
+    }
+    for (std::vector<Tokens> &rows : tokens_) {
+        insertRows(&rows, first, last - first + 1);
+    }
+}
+
+void SourceData::sourceRowsAboutToBeMoved(const QModelIndex &parent, int first, int last, const QModelIndex &destination, int row)
+{
+    if (parent.isValid() || destination.isValid())
+        return;
+
+    // The destination row is specified relative to the items before the move
+    const int count(last - first + 1);
+    const int insertIndex(row > first ? row - count : row);
+    for (std::vector<Value> &rows : values_) {
+        moveRows(&rows, first, count, insertIndex);
+    }
+    for (std::vector<Tokens> &rows : tokens_) {
+        moveRows(&rows, first, count, insertIndex);
+    }
+}
+
+void SourceData::sourceRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last)
+{
+    if (parent.isValid())
+        return;
+
+    for (std::vector<Value> &rows : values_) {
+        removeRows(&rows, first, last - first + 1);
+    }
+    for (std::vector<Tokens> &rows : tokens_) {
+        removeRows(&rows, first, last - first + 1);
+    }
+}
+
+void SourceData::sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles)
+{
+    if (!topLeft.parent().isValid()) {
+        const int first(topLeft.row());
+        const int last(bottomRight.row());
+        if (roles.isEmpty()) {
+            for (std::vector<Value> &rows : values_) {
+                clearRows(&rows, first, last);
+            }
+        } else {
+            for (int role : roles) {
+                auto it = values_.find(role);
+                if (it != values_.end()) {
+                    clearRows(&*it, first, last);
+                }
+            }
+        }
+
+        // The roles contributing to the tokens are not known here
+        for (std::vector<Tokens> &rows : tokens_) {
+            clearRows(&rows, first, last);
+        }
+    }
+
+    // Users read the changed rows again only once they have been discarded
+    emit dataChanged(topLeft, bottomRight, roles);
+}
+
+void SourceData::sourceCleared()
+{
+    values_.clear();
+    if (!tokens_.isEmpty()) {
+        tokens_.clear();
+        SearchTokenPool::release(this);
+    }
+}
+
+void SourceData::sourceDestroyed()
+{
+    // Another model may later be created at the same address
+    sharedData().remove(model_);
+    model_ = 0;
+    sourceCleared();
+}
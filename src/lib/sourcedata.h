@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2026 nemo-qml-plugin-models contributors
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef SOURCEDATA_H
+#define SOURCEDATA_H
+
+#include "searchmodel.h"
+
+#include <QAbstractItemModel>
+#include <QHash>
+#include <QString>
+#include <QVariant>
+
+#include <memory>
+#include <vector>
+
+// Role values and search tokens read from the rows of a source model, shared by each of the
+// filter models of that source which share source data, so that the values of a row are read
+// and tokenized only once.  The rows are updated before the source reports any change to its
+// rows.  Changed rows are discarded, and the change is then reported to the users by dataChanged.
+class SourceData : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~SourceData();
+
+    static std::shared_ptr<SourceData> attach(QAbstractItemModel *model);
+
+    bool findValue(int row, int role, QVariant *value) const;
+    void insertValue(int row, int role, const QVariant &value);
+
+    bool findTokens(int row, const QString &configuration, int forms, SearchModel::TokenList *tokens) const;
+    void insertTokens(int row, const QString &configuration, int forms, const SearchModel::TokenList &tokens);
+
+signals:
+    void dataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles);
+
+private slots:
+    void sourceRowsAboutToBeInserted(const QModelIndex &parent, int first, int last);
+    void sourceRowsAboutToBeMoved(const QModelIndex &parent, int first, int last, const QModelIndex &destination, int row);
+    void sourceRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+    void sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles);
+    void sourceCleared();
+    void sourceDestroyed();
+
+private:
+    explicit SourceData(QAbstractItemModel *model);
+
+    void markTokens(std::vector<bool> *live) const;
+
+    struct Value {
+        QVariant value;
+        bool valid;
+    };
+
+    struct Tokens {
+        SearchModel::TokenList tokens;
+        int forms;
+    };
+
+    QAbstractItemModel *model_;
+
+    // Values are stored per role, and tokens per search configuration; each has an entry for every row
+    QHash<int, std::vector<Value>> values_;
+    QHash<QString, std::vector<Tokens>> tokens_;
+};
+
+#endif // SOURCEDATA_H
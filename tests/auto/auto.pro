@@ -1,9 +1,18 @@
-TEMPLATE = aux
+TARGET = tst_models
+
+CONFIG += qmltestcase
+
+SOURCES += \
+    tst_models.cpp
 
 QML_FILES =  tst_*.qml
 OTHER_FILES += $${QML_FILES}
 
-target.files = $${QML_FILES}
+qml.files = $${QML_FILES}
+qml.path = /opt/tests/nemo-qml-plugins/models/auto
+
 target.path = /opt/tests/nemo-qml-plugins/models/auto
 
-INSTALLS += target
+INSTALLS += target qml
+
+include(../../src/src.pri)
@@ -124,6 +124,10 @@ Item {
         id: filterModel
     }
 
+    FilterModel {
+        id: chainedModel
+    }
+
     Repeater {
         id: repeater
 
@@ -334,5 +338,382 @@ Item {
             filterModel.filters = []
             compare(repeater.count, 5)
         }
+
+        function test_e_retained_results() {
+            repeater.model = null
+            compare(repeater.count, 0)
+
+            filterModel.sourceModel = baseModel
+            filterModel.filterRequirement = FilterModel.PassAllFilters
+            repeater.model = filterModel
+
+            var maleFilter = { 'role': 'gender', 'comparator': '==', 'value': 'male' }
+            var orderFilter = { 'role': 'order', 'comparator': '>=', 'value': 3 }
+
+            filterModel.filters = [ maleFilter, orderFilter ]
+            compare(repeater.count, 2)
+
+            // Removing and restoring a filter reuses the results of the other
+            filterModel.filters = [ maleFilter ]
+            compare(repeater.count, 3)
+            compare(repeater.itemAt(0).nameValue, 'Bob')
+
+            filterModel.filters = [ maleFilter, orderFilter ]
+            compare(repeater.count, 2)
+            compare(repeater.itemAt(0).nameValue, 'Charlie')
+            compare(repeater.itemAt(1).nameValue, 'Eddie')
+
+            // Results are updated for changed items
+            baseModel.setProperty(3, 'gender', 'male')
+            compare(repeater.count, 3)
+            compare(repeater.itemAt(1).nameValue, 'Debbie')
+
+            filterModel.filterRequirement = FilterModel.PassAnyFilter
+            compare(repeater.count, 4)
+
+            baseModel.setProperty(3, 'gender', 'female')
+            compare(repeater.count, 4)
+
+            filterModel.filterRequirement = FilterModel.PassAllFilters
+            compare(repeater.count, 2)
+
+            // Results are retained for items that are inserted and removed
+            baseModel.insert(0, { 'order': 6, 'name': 'Fred', 'gender': 'male' })
+            compare(repeater.count, 3)
+            compare(repeater.itemAt(0).nameValue, 'Fred')
+
+            filterModel.filters = [ orderFilter, maleFilter ]
+            compare(repeater.count, 3)
+            compare(repeater.itemAt(0).nameValue, 'Fred')
+            compare(repeater.itemAt(1).nameValue, 'Charlie')
+            compare(repeater.itemAt(2).nameValue, 'Eddie')
+
+            baseModel.remove(0)
+            compare(repeater.count, 2)
+
+            filterModel.filters = []
+            compare(repeater.count, 5)
+        }
+
+        function test_f_nested_filters() {
+            repeater.model = null
+            compare(repeater.count, 0)
+
+            filterModel.sourceModel = baseModel
+            filterModel.filterRequirement = FilterModel.PassAllFilters
+            repeater.model = filterModel
+
+            var maleFilter = { 'role': 'gender', 'comparator': '==', 'value': 'male' }
+            var nameFilter = { 'role': 'name', 'comparator': 'match', 'value': 'ie\\b' }
+            var lowFilter = { 'role': 'order', 'comparator': '<', 'value': 2 }
+
+            // (male and name ends with 'ie') or order < 2
+            filterModel.filters = [{ 'any': [{ 'all': [ nameFilter, maleFilter ] }, lowFilter ] }]
+            compare(repeater.count, 3)
+            compare(repeater.itemAt(0).nameValue, 'Alice')
+            compare(repeater.itemAt(1).nameValue, 'Charlie')
+            compare(repeater.itemAt(2).nameValue, 'Eddie')
+
+            // The nested form is retained
+            compare(filterModel.filters.length, 1)
+            compare(filterModel.filters[0].any.length, 2)
+            compare(filterModel.filters[0].any[0].all.length, 2)
+            compare(filterModel.filters[0].any[0].all[0].comparator, 'match')
+            compare(filterModel.filters[0].any[1].value, 2)
+
+            // Groups combine with top-level filters according to the filter requirement
+            filterModel.filters = [ maleFilter, { 'any': [ nameFilter, lowFilter ] } ]
+            compare(repeater.count, 2)
+            compare(repeater.itemAt(0).nameValue, 'Charlie')
+            compare(repeater.itemAt(1).nameValue, 'Eddie')
+
+            filterModel.filterRequirement = FilterModel.PassAnyFilter
+            compare(repeater.count, 5)
+
+            filterModel.filterRequirement = FilterModel.PassAllFilters
+            baseModel.setProperty(2, 'gender', 'female')
+            compare(repeater.count, 1)
+            compare(repeater.itemAt(0).nameValue, 'Eddie')
+
+            baseModel.setProperty(2, 'gender', 'male')
+            compare(repeater.count, 2)
+
+            // Empty groups
+            filterModel.filters = [{ 'all': [] }]
+            compare(repeater.count, 5)
+
+            filterModel.filters = [{ 'any': [] }]
+            compare(repeater.count, 0)
+
+            filterModel.filters = []
+            compare(repeater.count, 5)
+        }
+
+        function test_g_typed_comparison() {
+            repeater.model = null
+            compare(repeater.count, 0)
+
+            filterModel.sourceModel = baseModel
+            filterModel.filterRequirement = FilterModel.PassAllFilters
+            repeater.model = filterModel
+
+            filterModel.filters = [{ 'role': 'order', 'comparator': '>=', 'value': 2.5 }]
+            compare(repeater.count, 3)
+            compare(repeater.itemAt(0).nameValue, 'Charlie')
+
+            filterModel.filters = [{ 'role': 'order', 'comparator': '==', 'value': 3 }]
+            compare(repeater.count, 1)
+            compare(repeater.itemAt(0).nameValue, 'Charlie')
+
+            filterModel.filters = [{ 'role': 'order', 'comparator': '!=', 'value': 3 }]
+            compare(repeater.count, 4)
+
+            filterModel.filters = [{ 'role': 'name', 'comparator': '<', 'value': 'c' }]
+            compare(repeater.count, 5)
+
+            filterModel.filters = [{ 'role': 'name', 'comparator': '<', 'value': 'c', 'caseSensitivity': Qt.CaseInsensitive }]
+            compare(repeater.count, 2)
+            compare(repeater.itemAt(0).nameValue, 'Alice')
+            compare(repeater.itemAt(1).nameValue, 'Bob')
+            compare(filterModel.filters[0].caseSensitivity, Qt.CaseInsensitive)
+
+            filterModel.filters = [{ 'role': 'name', 'comparator': '==', 'value': 'bob', 'caseSensitivity': Qt.CaseInsensitive }]
+            compare(repeater.count, 1)
+            compare(repeater.itemAt(0).nameValue, 'Bob')
+
+            filterModel.filters = [{ 'role': 'name', 'comparator': '==', 'value': 'bob' }]
+            compare(repeater.count, 0)
+
+            // Comparisons without a typed form also respect the case sensitivity
+            filterModel.filters = [{ 'role': 'name', 'comparator': 'match', 'value': '^B', 'caseSensitivity': Qt.CaseInsensitive }]
+            compare(repeater.count, 1)
+            compare(repeater.itemAt(0).nameValue, 'Bob')
+
+            filterModel.filters = [{ 'role': 'name', 'comparator': 'match', 'value': '^b' }]
+            compare(repeater.count, 0)
+
+            filterModel.filters = []
+            compare(repeater.count, 5)
+        }
+
+        function test_h_set_and_range() {
+            repeater.model = null
+            compare(repeater.count, 0)
+
+            filterModel.sourceModel = baseModel
+            filterModel.filterRequirement = FilterModel.PassAllFilters
+            repeater.model = filterModel
+
+            filterModel.filters = [{ 'role': 'name', 'comparator': 'in', 'value': [ 'Bob', 'Eddie', 'Zed' ] }]
+            compare(repeater.count, 2)
+            compare(repeater.itemAt(0).nameValue, 'Bob')
+            compare(repeater.itemAt(1).nameValue, 'Eddie')
+
+            filterModel.filters = [{ 'role': 'name', 'comparator': '!in', 'value': [ 'Bob', 'Eddie', 'Zed' ] }]
+            compare(repeater.count, 3)
+            compare(repeater.itemAt(0).nameValue, 'Alice')
+
+            filterModel.filters = [{ 'role': 'name', 'comparator': 'in', 'value': [ 'alice', 'DEBBIE' ], 'caseSensitivity': Qt.CaseInsensitive }]
+            compare(repeater.count, 2)
+            compare(repeater.itemAt(0).nameValue, 'Alice')
+            compare(repeater.itemAt(1).nameValue, 'Debbie')
+
+            filterModel.filters = [{ 'role': 'order', 'comparator': 'in', 'value': [ 1, 5 ] }]
+            compare(repeater.count, 2)
+            compare(repeater.itemAt(0).nameValue, 'Alice')
+            compare(repeater.itemAt(1).nameValue, 'Eddie')
+
+            // The lower bound is included and the upper bound is excluded
+            filterModel.filters = [{ 'role': 'order', 'comparator': 'between', 'value': [ 2, 4 ] }]
+            compare(repeater.count, 2)
+            compare(repeater.itemAt(0).nameValue, 'Bob')
+            compare(repeater.itemAt(1).nameValue, 'Charlie')
+
+            filterModel.filters = [{ 'role': 'order', 'comparator': '!between', 'value': [ 2, 4 ] }]
+            compare(repeater.count, 3)
+            compare(repeater.itemAt(0).nameValue, 'Alice')
+            compare(repeater.itemAt(1).nameValue, 'Debbie')
+
+            filterModel.filters = [{ 'role': 'name', 'comparator': 'between', 'value': [ 'B', 'D' ] }]
+            compare(repeater.count, 2)
+            compare(repeater.itemAt(0).nameValue, 'Bob')
+            compare(repeater.itemAt(1).nameValue, 'Charlie')
+            compare(filterModel.filters[0].comparator, 'between')
+
+            filterModel.filters = []
+            compare(repeater.count, 5)
+        }
+
+        function test_i_get_roles() {
+            filterModel.sourceModel = baseModel
+            filterModel.filterRequirement = FilterModel.PassAllFilters
+            filterModel.filters = [{ 'role': 'gender', 'comparator': '==', 'value': 'male' }]
+            compare(filterModel.count, 3)
+
+            compare(filterModel.getRole(1, 0, 'name'), 'Charlie')
+            compare(filterModel.getRole(1, 0, 'missing'), undefined)
+
+            var roles = filterModel.getRoles(1, 0)
+            compare(roles.name, 'Charlie')
+            compare(roles.gender, 'male')
+            compare(roles.order, 3)
+
+            roles = filterModel.getRoles(2, 0, [ 'name', 'missing' ])
+            compare(roles.name, 'Eddie')
+            compare(roles.gender, undefined)
+
+            filterModel.filters = []
+            compare(filterModel.count, 5)
+        }
+
+        function test_j_source_moves() {
+            repeater.model = null
+            compare(repeater.count, 0)
+
+            filterModel.sourceModel = baseModel
+            filterModel.filterRequirement = FilterModel.PassAllFilters
+            filterModel.filters = [{ 'role': 'gender', 'comparator': '==', 'value': 'male' }]
+            repeater.model = filterModel
+            compare(repeater.count, 3)
+
+            // Move Alice and Bob after Eddie
+            baseModel.move(0, 3, 2)
+            compare(repeater.count, 3)
+            compare(repeater.itemAt(0).nameValue, 'Charlie')
+            compare(repeater.itemAt(1).nameValue, 'Eddie')
+            compare(repeater.itemAt(2).nameValue, 'Bob')
+
+            // Results are retained for the moved items
+            filterModel.filters = [{ 'role': 'gender', 'comparator': '==', 'value': 'male' }, { 'role': 'order', 'comparator': '<', 'value': 5 }]
+            compare(repeater.count, 2)
+            compare(repeater.itemAt(0).nameValue, 'Charlie')
+            compare(repeater.itemAt(1).nameValue, 'Bob')
+
+            // Move Debbie to the end, which does not reorder the filtered items
+            baseModel.move(1, 4, 1)
+            compare(repeater.count, 2)
+            compare(repeater.itemAt(0).nameValue, 'Charlie')
+            compare(repeater.itemAt(1).nameValue, 'Bob')
+
+            // Restore the original order
+            baseModel.move(2, 0, 2)
+            baseModel.move(4, 3, 1)
+            compare(baseModel.get(0).name, 'Alice')
+            compare(baseModel.get(3).name, 'Debbie')
+            compare(repeater.count, 2)
+            compare(repeater.itemAt(0).nameValue, 'Bob')
+            compare(repeater.itemAt(1).nameValue, 'Charlie')
+
+            filterModel.filters = []
+            compare(repeater.count, 5)
+        }
+
+        function test_k_chained_models() {
+            repeater.model = null
+            compare(repeater.count, 0)
+
+            filterModel.sourceModel = baseModel
+            filterModel.filterRequirement = FilterModel.PassAllFilters
+            filterModel.filters = [{ 'role': 'gender', 'comparator': '==', 'value': 'male' }]
+            compare(filterModel.count, 3)
+
+            chainedModel.sourceModel = filterModel
+            chainedModel.filters = [{ 'role': 'order', 'comparator': '>', 'value': 2 }]
+            repeater.model = chainedModel
+            compare(chainedModel.count, 2)
+            compare(repeater.count, 2)
+            compare(repeater.itemAt(0).nameValue, 'Charlie')
+            compare(repeater.itemAt(1).nameValue, 'Eddie')
+
+            compare(chainedModel.getRole(1, 0, 'name'), 'Eddie')
+            var roles = chainedModel.getRoles(0, 0)
+            compare(roles.name, 'Charlie')
+            compare(roles.order, 3)
+
+            // Changes to the original source are reflected through both models
+            baseModel.insert(1, { 'order': 6, 'name': 'Fred', 'gender': 'male' })
+            compare(filterModel.count, 4)
+            compare(repeater.count, 3)
+            compare(repeater.itemAt(0).nameValue, 'Fred')
+            compare(repeater.itemAt(1).nameValue, 'Charlie')
+            compare(chainedModel.getRole(0, 0, 'order'), 6)
+
+            baseModel.setProperty(5, 'order', 1)
+            compare(repeater.count, 2)
+            compare(repeater.itemAt(0).nameValue, 'Fred')
+            compare(repeater.itemAt(1).nameValue, 'Charlie')
+
+            baseModel.setProperty(5, 'order', 5)
+            baseModel.remove(1)
+            compare(repeater.count, 2)
+            compare(repeater.itemAt(0).nameValue, 'Charlie')
+            compare(repeater.itemAt(1).nameValue, 'Eddie')
+
+            chainedModel.filters = []
+            compare(repeater.count, 3)
+            compare(repeater.itemAt(0).nameValue, 'Bob')
+
+            repeater.model = null
+            chainedModel.sourceModel = null
+            filterModel.filters = []
+            compare(filterModel.count, 5)
+        }
+
+        function test_l_shared_source_data() {
+            filterModel.sourceModel = baseModel
+            filterModel.filterRequirement = FilterModel.PassAllFilters
+            filterModel.filters = [{ 'role': 'gender', 'comparator': '==', 'value': 'male' }]
+            filterModel.shareSourceData = true
+            compare(filterModel.count, 3)
+
+            chainedModel.shareSourceData = true
+            chainedModel.sourceModel = baseModel
+            chainedModel.filters = [{ 'role': 'order', 'comparator': '>', 'value': 2 }]
+            compare(chainedModel.count, 3)
+            compare(chainedModel.getRole(0, 0, 'name'), 'Charlie')
+
+            // Both models reflect changes to the shared source values
+            baseModel.setProperty(1, 'order', 7)
+            compare(filterModel.count, 3)
+            compare(chainedModel.count, 4)
+            compare(chainedModel.getRole(0, 0, 'name'), 'Bob')
+
+            baseModel.setProperty(1, 'gender', 'female')
+            compare(filterModel.count, 2)
+            compare(filterModel.getRole(0, 0, 'name'), 'Charlie')
+
+            baseModel.insert(0, { 'order': 0, 'name': 'Fred', 'gender': 'male' })
+            compare(filterModel.count, 3)
+            compare(filterModel.getRole(0, 0, 'name'), 'Fred')
+            compare(chainedModel.count, 4)
+
+            baseModel.move(0, 5, 1)
+            compare(filterModel.getRole(2, 0, 'name'), 'Fred')
+            baseModel.remove(5)
+            compare(filterModel.count, 2)
+
+            // Restore the original values
+            baseModel.setProperty(1, 'order', 2)
+            baseModel.setProperty(1, 'gender', 'male')
+            compare(filterModel.count, 3)
+            compare(chainedModel.count, 3)
+
+            // Sharing can be stopped and resumed while the model is in use
+            filterModel.shareSourceData = false
+            compare(filterModel.count, 3)
+            baseModel.setProperty(0, 'gender', 'male')
+            compare(filterModel.count, 4)
+            filterModel.shareSourceData = true
+            compare(filterModel.count, 4)
+            baseModel.setProperty(0, 'gender', 'female')
+            compare(filterModel.count, 3)
+            compare(filterModel.getRole(0, 0, 'name'), 'Bob')
+
+            chainedModel.sourceModel = null
+            chainedModel.shareSourceData = false
+            filterModel.shareSourceData = false
+            filterModel.filters = []
+            compare(filterModel.count, 5)
+        }
     }
 }
@@ -235,10 +235,35 @@ Item {
         }
     }
 
+    ListModel {
+        id: relevanceModel
+
+        ListElement {
+            name: 'Mandy Andrews'
+            order: 1
+        }
+        ListElement {
+            name: 'Andy'
+            order: 2
+        }
+        ListElement {
+            name: 'Anders'
+            order: 3
+        }
+        ListElement {
+            name: 'Bob Andy'
+            order: 4
+        }
+    }
+
     SearchModel {
         id: searchModel
     }
 
+    SearchModel {
+        id: cachedSearchModel
+    }
+
     Repeater {
         id: repeater
 
@@ -265,6 +290,7 @@ Item {
         function init() {
         }
         function cleanup() {
+            testFiles.remove('tst_searchmodel.tokens')
         }
 
         function test_a_unused() {
@@ -273,6 +299,12 @@ Item {
             compare(searchModel.pattern, '')
             compare(searchModel.caseSensitivity, Qt.CaseSensitive)
             compare(searchModel.matchType, SearchModel.MatchBeginning)
+            compare(searchModel.maximumEditDistance, 1)
+            compare(searchModel.sortByRelevance, false)
+            compare(searchModel.tokenCacheFile, '')
+            compare(searchModel.tokenCacheKeyRole, '')
+            compare(searchModel.pretokenize, false)
+            compare(searchModel.tokenizationProgress, 1.0)
         }
 
         function test_b_unfiltered() {
@@ -818,5 +850,288 @@ Item {
             compare(repeater.count, 1)
             compare(repeater.itemAt(0).orderValue, 2)
         }
+
+        function test_h_relevance() {
+            repeater.model = null
+            compare(repeater.count, 0)
+
+            searchModel.sourceModel = null
+            searchModel.searchRoles = []
+            searchModel.pattern = ''
+
+            searchModel.sourceModel = relevanceModel
+            compare(searchModel.populated, true)
+            compare(searchModel.count, 4)
+
+            repeater.model = searchModel
+
+            searchModel.caseSensitivity = Qt.CaseInsensitive
+            searchModel.matchType = SearchModel.MatchAnywhere
+            searchModel.searchRoles = [ 'name' ]
+
+            searchModel.pattern = 'andy'
+            compare(repeater.count, 3)
+            compare(repeater.itemAt(0).orderValue, 1)
+            compare(repeater.itemAt(1).orderValue, 2)
+            compare(repeater.itemAt(2).orderValue, 4)
+
+            // Exact matches precede prefix matches, which precede matches within a word
+            searchModel.sortByRelevance = true
+            compare(repeater.count, 3)
+            compare(repeater.itemAt(0).orderValue, 2)
+            compare(repeater.itemAt(1).orderValue, 4)
+            compare(repeater.itemAt(2).orderValue, 1)
+
+            // Matches in earlier words precede later words; ties retain the source order
+            searchModel.pattern = 'and'
+            compare(repeater.count, 4)
+            compare(repeater.itemAt(0).orderValue, 2)
+            compare(repeater.itemAt(1).orderValue, 3)
+            compare(repeater.itemAt(2).orderValue, 1)
+            compare(repeater.itemAt(3).orderValue, 4)
+
+            // Changed items are re-ranked
+            relevanceModel.setProperty(0, 'name', 'And')
+            compare(repeater.count, 4)
+            compare(repeater.itemAt(0).orderValue, 1)
+            compare(repeater.itemAt(1).orderValue, 2)
+            compare(repeater.itemAt(2).orderValue, 3)
+            compare(repeater.itemAt(3).orderValue, 4)
+
+            relevanceModel.setProperty(0, 'name', 'Mandy Andrews')
+            compare(repeater.itemAt(0).orderValue, 2)
+            compare(repeater.itemAt(1).orderValue, 3)
+            compare(repeater.itemAt(2).orderValue, 1)
+            compare(repeater.itemAt(3).orderValue, 4)
+
+            // Moved items retain their ranking, with ties in the new source order
+            relevanceModel.move(1, 2, 1)
+            compare(repeater.count, 4)
+            compare(repeater.itemAt(0).orderValue, 3)
+            compare(repeater.itemAt(1).orderValue, 2)
+            compare(repeater.itemAt(2).orderValue, 1)
+            compare(repeater.itemAt(3).orderValue, 4)
+
+            relevanceModel.move(2, 1, 1)
+            compare(repeater.itemAt(0).orderValue, 2)
+            compare(repeater.itemAt(1).orderValue, 3)
+
+            // Without a pattern, the source order is restored
+            searchModel.pattern = ''
+            compare(repeater.count, 4)
+            compare(repeater.itemAt(0).orderValue, 1)
+            compare(repeater.itemAt(1).orderValue, 2)
+            compare(repeater.itemAt(2).orderValue, 3)
+            compare(repeater.itemAt(3).orderValue, 4)
+
+            searchModel.pattern = 'and'
+            compare(repeater.itemAt(0).orderValue, 2)
+            compare(repeater.itemAt(1).orderValue, 3)
+            compare(repeater.itemAt(2).orderValue, 1)
+            compare(repeater.itemAt(3).orderValue, 4)
+
+            searchModel.sortByRelevance = false
+            compare(repeater.count, 4)
+            compare(repeater.itemAt(0).orderValue, 1)
+            compare(repeater.itemAt(1).orderValue, 2)
+            compare(repeater.itemAt(2).orderValue, 3)
+            compare(repeater.itemAt(3).orderValue, 4)
+
+            searchModel.matchType = SearchModel.MatchBeginning
+            searchModel.caseSensitivity = Qt.CaseSensitive
+        }
+
+        function test_i_fuzzy() {
+            repeater.model = null
+            compare(repeater.count, 0)
+
+            searchModel.sourceModel = null
+            searchModel.searchRoles = []
+            searchModel.pattern = ''
+
+            searchModel.sourceModel = baseModel
+            compare(searchModel.populated, true)
+            compare(searchModel.count, 5)
+
+            repeater.model = searchModel
+
+            searchModel.searchRoles = [ 'name' ]
+            searchModel.matchType = SearchModel.MatchFuzzy
+
+            searchModel.pattern = 'Andi'
+            compare(repeater.count, 1)
+            compare(repeater.itemAt(0).nameValue, 'Andy')
+
+            searchModel.pattern = 'Ant'
+            compare(repeater.count, 3)
+            compare(repeater.itemAt(0).nameValue, 'Andy')
+            compare(repeater.itemAt(1).nameValue, 'Antonio')
+            compare(repeater.itemAt(2).nameValue, 'Antti')
+
+            searchModel.maximumEditDistance = 0
+            compare(repeater.count, 2)
+            compare(repeater.itemAt(0).nameValue, 'Antonio')
+            compare(repeater.itemAt(1).nameValue, 'Antti')
+
+            searchModel.maximumEditDistance = 1
+            compare(repeater.count, 3)
+
+            // Short patterns are not permitted any errors
+            searchModel.pattern = 'An'
+            compare(repeater.count, 3)
+            compare(repeater.itemAt(0).nameValue, 'Andy')
+
+            searchModel.matchType = SearchModel.MatchBeginning
+        }
+
+        function test_j_token_cache() {
+            repeater.model = null
+            compare(repeater.count, 0)
+
+            searchModel.sourceModel = null
+            searchModel.searchRoles = [ 'name' ]
+            searchModel.pattern = ''
+
+            // The cache is written to a file private to this run
+            testFiles.remove('tst_searchmodel.tokens')
+            searchModel.tokenCacheFile = testFiles.path('tst_searchmodel.tokens')
+            searchModel.tokenCacheKeyRole = 'order'
+            searchModel.sourceModel = relevanceModel
+            compare(searchModel.count, 4)
+
+            searchModel.pattern = 'Andy'
+            compare(searchModel.count, 2)
+            compare(searchModel.saveTokenCache(), true)
+
+            // A model reading the persisted tokens produces the same results
+            cachedSearchModel.searchRoles = [ 'name' ]
+            cachedSearchModel.tokenCacheFile = testFiles.path('tst_searchmodel.tokens')
+            cachedSearchModel.tokenCacheKeyRole = 'order'
+            cachedSearchModel.sourceModel = relevanceModel
+            cachedSearchModel.pattern = 'Andy'
+            compare(cachedSearchModel.count, 2)
+            repeater.model = cachedSearchModel
+            compare(repeater.itemAt(0).orderValue, 2)
+            compare(repeater.itemAt(1).orderValue, 4)
+
+            // Persisted tokens are not used for rows whose content has changed
+            relevanceModel.setProperty(1, 'name', 'Bob')
+            compare(cachedSearchModel.count, 1)
+            relevanceModel.setProperty(1, 'name', 'Andy')
+            compare(cachedSearchModel.count, 2)
+
+            repeater.model = null
+            cachedSearchModel.sourceModel = null
+            cachedSearchModel.tokenCacheFile = ''
+            searchModel.sourceModel = null
+            searchModel.tokenCacheFile = ''
+            searchModel.tokenCacheKeyRole = ''
+            searchModel.pattern = ''
+        }
+
+        function test_k_pretokenize() {
+            repeater.model = null
+            compare(repeater.count, 0)
+
+            searchModel.sourceModel = null
+            searchModel.searchRoles = [ 'name' ]
+            searchModel.pattern = ''
+
+            // Progress is not reported while rows are only tokenized on demand
+            searchModel.sourceModel = baseModel
+            searchModel.pattern = 'Ant'
+            compare(searchModel.count, 2)
+            compare(searchModel.tokenizationProgress, 1.0)
+            searchModel.sourceModel = null
+            searchModel.pattern = ''
+
+            searchModel.pretokenize = true
+            searchModel.sourceModel = baseModel
+            compare(searchModel.count, 5)
+            compare(searchModel.tokenizationProgress, 0)
+
+            // Tokens are prepared when the event loop is idle
+            tryCompare(searchModel, 'tokenizationProgress', 1.0)
+
+            repeater.model = searchModel
+            searchModel.pattern = 'Ant'
+            compare(repeater.count, 2)
+            compare(repeater.itemAt(0).nameValue, 'Antonio')
+            compare(repeater.itemAt(1).nameValue, 'Antti')
+
+            // Changed rows are tokenized again
+            baseModel.setProperty(4, 'name', 'Antero')
+            compare(searchModel.tokenizationProgress < 1.0, true)
+            tryCompare(searchModel, 'tokenizationProgress', 1.0)
+            compare(repeater.count, 3)
+            baseModel.setProperty(4, 'name', 'Bob')
+            compare(repeater.count, 2)
+
+            // Only the rows without tokens are pending
+            tryCompare(searchModel, 'tokenizationProgress', 1.0)
+            baseModel.insert(0, { 'order': 6, 'name': 'Bert', 'gender': 'male' })
+            compare(searchModel.tokenizationProgress, 5 / 6)
+            tryCompare(searchModel, 'tokenizationProgress', 1.0)
+            baseModel.remove(0)
+
+            repeater.model = null
+            searchModel.pretokenize = false
+            searchModel.sourceModel = null
+            searchModel.pattern = ''
+        }
+
+        function test_l_part_refinement() {
+            repeater.model = null
+            compare(repeater.count, 0)
+
+            searchModel.sourceModel = null
+            searchModel.searchRoles = [ 'name' ]
+            searchModel.pattern = ''
+
+            searchModel.sourceModel = relevanceModel
+            compare(searchModel.count, 4)
+
+            repeater.model = searchModel
+
+            searchModel.pattern = 'Andy'
+            compare(repeater.count, 2)
+            compare(repeater.itemAt(0).orderValue, 2)
+            compare(repeater.itemAt(1).orderValue, 4)
+
+            // Words added before the existing words refine the results
+            searchModel.pattern = 'Bob Andy'
+            compare(repeater.count, 1)
+            compare(repeater.itemAt(0).orderValue, 4)
+
+            // Words shortened in the middle of the pattern unrefine the results
+            searchModel.pattern = 'Bo Andy'
+            compare(repeater.count, 1)
+            compare(repeater.itemAt(0).orderValue, 4)
+
+            searchModel.pattern = 'Andy'
+            compare(repeater.count, 2)
+            compare(repeater.itemAt(0).orderValue, 2)
+            compare(repeater.itemAt(1).orderValue, 4)
+
+            searchModel.pattern = 'Ma An'
+            compare(repeater.count, 1)
+            compare(repeater.itemAt(0).orderValue, 1)
+
+            // Reordered words match the same items
+            searchModel.pattern = 'An Ma'
+            compare(repeater.count, 1)
+            compare(repeater.itemAt(0).orderValue, 1)
+
+            searchModel.pattern = 'An'
+            compare(repeater.count, 4)
+            compare(repeater.itemAt(0).orderValue, 1)
+            compare(repeater.itemAt(1).orderValue, 2)
+            compare(repeater.itemAt(2).orderValue, 3)
+            compare(repeater.itemAt(3).orderValue, 4)
+
+            repeater.model = null
+            searchModel.sourceModel = null
+            searchModel.pattern = ''
+        }
     }
 }
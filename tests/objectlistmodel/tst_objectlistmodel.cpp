@@ -56,6 +56,14 @@ private slots:
     void testSimpleExport();
     void testRoleMap();
     void testUpdate();
+    void testRoleProperties();
+    void testNotifyChanges();
+    void testBatchChanges();
+    void testBlockOperations();
+    void testLargeSynchronization();
+    void testDestroyedItems();
+    void testKeyedSynchronization();
+    void testBatchUpdate();
 };
 
 void tst_ObjectListModel::init()
@@ -723,6 +731,437 @@ void tst_ObjectListModel::testUpdate()
     model.clear();
 }
 
+void tst_ObjectListModel::testRoleProperties()
+{
+    ObjectListModel model(0, true, true);
+
+    TestObject to(QString("Istiophoridae"), QString("Istiophorus Lacépède"), QString("Istiophorus albicans"));
+    to.setProperty("dynamic", QVariant::fromValue(2.0));
+    model.appendItem(&to);
+
+    // An item of a different type is read by property name
+    QObject obj;
+    obj.setProperty("family", QVariant::fromValue(QString("Chlamyphoridae")));
+    obj.setProperty("dynamic", QVariant::fromValue(4.0));
+    model.appendItem(&obj);
+
+    const QHash<int, QByteArray> roles(model.roleNames());
+    const QModelIndex firstIndex(model.index(0, 0));
+    QCOMPARE(model.data(firstIndex, roles.key(QByteArray("family"))), QVariant::fromValue(QString("Istiophoridae")));
+    QCOMPARE(model.data(firstIndex, roles.key(QByteArray("species"))), QVariant::fromValue(QString("Istiophorus albicans")));
+    QCOMPARE(model.data(firstIndex, roles.key(QByteArray("dynamic"))).toDouble(), 2.0);
+
+    to.setCommonName("Sailfish");
+    to.setProperty("dynamic", QVariant::fromValue(3.0));
+    QCOMPARE(model.data(firstIndex, roles.key(QByteArray("commonName"))), QVariant::fromValue(QString("Sailfish")));
+    QCOMPARE(model.data(firstIndex, roles.key(QByteArray("dynamic"))).toDouble(), 3.0);
+
+    const QModelIndex secondIndex(model.index(1, 0));
+    QCOMPARE(model.data(secondIndex, roles.key(QByteArray("family"))), QVariant::fromValue(QString("Chlamyphoridae")));
+    QCOMPARE(model.data(secondIndex, roles.key(QByteArray("dynamic"))).toDouble(), 4.0);
+    QCOMPARE(model.data(secondIndex, roles.key(QByteArray("species"))), QVariant());
+
+    model.clear();
+}
+
+void tst_ObjectListModel::testNotifyChanges()
+{
+    ObjectListModel model(0, true, true);
+    QCOMPARE(model.notifyChanges(), false);
+
+    TestObject toA(QString("Istiophoridae"), QString("Istiophorus Lacépède"), QString("Istiophorus albicans"));
+    TestObject toB(QString("Chlamyphoridae"), QString("Chlamyphorus Harlan"), QString("Chlamyphorus truncatus"));
+    TestObject toC(QString("Dasypodidae"), QString("Dasypus Linnaeus"), QString("Dasypus novemcinctus"));
+    model.appendItem(&toA);
+    model.appendItems(QList<QObject *>() << &toB << &toC);
+
+    QSignalSpy changedSpy(&model, &QAbstractItemModel::dataChanged);
+
+    toA.setCommonName("Sailfish");
+    QTest::qWait(10);
+    QCOMPARE(changedSpy.count(), 0);
+
+    model.setNotifyChanges(true);
+    QCOMPARE(model.notifyChanges(), true);
+
+    const QHash<int, QByteArray> roles(model.roleNames());
+    QVector<int> expectedRoles;
+    expectedRoles << roles.key(QByteArray("roles")) << roles.key(QByteArray("commonName"));
+    std::sort(expectedRoles.begin(), expectedRoles.end());
+
+    // Changes are coalesced into a single report for contiguous rows
+    toA.setCommonName("Atlantic sailfish");
+    toB.setCommonName("Pink fairy armadillo");
+    toA.setCommonName("Sailfish");
+    QCOMPARE(changedSpy.count(), 0);
+    QTRY_COMPARE(changedSpy.count(), 1);
+
+    QVariantList args = changedSpy.takeFirst();
+    QCOMPARE(qvariant_cast<QModelIndex>(args.at(0)).row(), 0);
+    QCOMPARE(qvariant_cast<QModelIndex>(args.at(1)).row(), 1);
+    QCOMPARE(qvariant_cast<QVector<int> >(args.at(2)), expectedRoles);
+
+    toA.setCommonName("Indo-Pacific sailfish");
+    toC.setCommonName("Nine-banded armadillo");
+    QTRY_COMPARE(changedSpy.count(), 2);
+
+    args = changedSpy.takeFirst();
+    QCOMPARE(qvariant_cast<QModelIndex>(args.at(0)).row(), 0);
+    QCOMPARE(qvariant_cast<QModelIndex>(args.at(1)).row(), 0);
+    args = changedSpy.takeFirst();
+    QCOMPARE(qvariant_cast<QModelIndex>(args.at(0)).row(), 2);
+    QCOMPARE(qvariant_cast<QModelIndex>(args.at(1)).row(), 2);
+
+    // Removed items are no longer tracked
+    model.removeItem(&toB);
+    toB.setCommonName("Armadillo");
+    QTest::qWait(10);
+    QCOMPARE(changedSpy.count(), 0);
+
+    // Items are tracked again once their roles are derived again
+    model.setAutomaticRoles(false);
+    model.setAutomaticRoles(true);
+    toC.setCommonName("Armadillo");
+    QTRY_COMPARE(changedSpy.count(), 1);
+    changedSpy.clear();
+
+    model.setNotifyChanges(false);
+    toA.setCommonName("Sailfish");
+    QTest::qWait(10);
+    QCOMPARE(changedSpy.count(), 0);
+
+    model.clear();
+}
+
+void tst_ObjectListModel::testBatchChanges()
+{
+    QList<QObject *> objects;
+    objects.append(makeObject("a"));
+    objects.append(makeObject("b"));
+    objects.append(makeObject("c"));
+    objects.append(makeObject("d"));
+    objects.append(makeObject("e"));
+
+    ObjectListModel model;
+    model.appendItems(objects);
+    QCOMPARE(model.batchChanges(), false);
+
+    model.setBatchChanges(true);
+    QCOMPARE(model.batchChanges(), true);
+
+    QSignalSpy changedSpy(&model, SIGNAL(dataChanged(QModelIndex,QModelIndex)));
+
+    // Changes to contiguous rows are merged into a single report
+    model.itemChangedAt(3);
+    model.itemChangedAt(1);
+    model.itemChanged(objects.at(2));
+    model.itemChangedAt(1);
+    model.itemChanged(objects.at(0));
+    model.itemChangedAt(4);
+    QCOMPARE(changedSpy.count(), 0);
+    QTRY_COMPARE(changedSpy.count(), 1);
+
+    QVariantList args = changedSpy.takeFirst();
+    QCOMPARE(qvariant_cast<QModelIndex>(args.at(0)).row(), 0);
+    QCOMPARE(qvariant_cast<QModelIndex>(args.at(1)).row(), 4);
+
+    // Rows are reported where the items are when the changes are reported
+    model.itemChangedAt(1);
+    model.itemChangedAt(4);
+    model.removeItemAt(0);
+    QTRY_COMPARE(changedSpy.count(), 2);
+
+    args = changedSpy.takeFirst();
+    QCOMPARE(qvariant_cast<QModelIndex>(args.at(0)).row(), 0);
+    QCOMPARE(qvariant_cast<QModelIndex>(args.at(1)).row(), 0);
+    args = changedSpy.takeFirst();
+    QCOMPARE(qvariant_cast<QModelIndex>(args.at(0)).row(), 3);
+    QCOMPARE(qvariant_cast<QModelIndex>(args.at(1)).row(), 3);
+
+    // Disabling batching reports any pending changes immediately
+    model.itemChangedAt(2);
+    model.setBatchChanges(false);
+    QCOMPARE(changedSpy.count(), 1);
+    changedSpy.clear();
+
+    model.itemChangedAt(2);
+    QCOMPARE(changedSpy.count(), 1);
+
+    qDeleteAll(objects);
+}
+
+void tst_ObjectListModel::testBlockOperations()
+{
+    QList<QObject *> objects;
+    objects.append(makeObject("a"));
+    objects.append(makeObject("b"));
+    objects.append(makeObject("c"));
+    objects.append(makeObject("d"));
+    objects.append(makeObject("e"));
+    objects.append(makeObject("f"));
+
+    ObjectListModel model;
+    model.appendItems(QList<QObject *>() << objects.at(0) << objects.at(5));
+
+    QSignalSpy addedSpy(&model, SIGNAL(itemAdded(QObject*)));
+    QSignalSpy countSpy(&model, SIGNAL(countChanged()));
+    QSignalSpy rowsInsertedSpy(&model, SIGNAL(rowsInserted(QModelIndex,int,int)));
+    QSignalSpy movedSpy(&model, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)));
+
+    model.insertItems(1, objects.mid(1, 4));
+
+    QCOMPARE(model.count(), 6);
+    QCOMPARE(::objectName(model.get(0)), QString("a"));
+    QCOMPARE(::objectName(model.get(1)), QString("b"));
+    QCOMPARE(::objectName(model.get(4)), QString("e"));
+    QCOMPARE(::objectName(model.get(5)), QString("f"));
+
+    QCOMPARE(addedSpy.count(), 4);
+    QCOMPARE(addedSpy.at(0), QVariantList() << QVariant::fromValue(objects.at(1)));
+    QCOMPARE(countSpy.count(), 1);
+    QCOMPARE(rowsInsertedSpy.count(), 1);
+    QCOMPARE(qvariant_cast<int>(rowsInsertedSpy.at(0).at(1)), 1);
+    QCOMPARE(qvariant_cast<int>(rowsInsertedSpy.at(0).at(2)), 4);
+
+    model.moveItems(0, 2, 3);
+
+    QCOMPARE(::objectName(model.get(0)), QString("c"));
+    QCOMPARE(::objectName(model.get(1)), QString("d"));
+    QCOMPARE(::objectName(model.get(2)), QString("e"));
+    QCOMPARE(::objectName(model.get(3)), QString("a"));
+    QCOMPARE(::objectName(model.get(4)), QString("b"));
+    QCOMPARE(::objectName(model.get(5)), QString("f"));
+
+    model.moveItems(3, 3, 0);
+
+    QCOMPARE(::objectName(model.get(0)), QString("a"));
+    QCOMPARE(::objectName(model.get(1)), QString("b"));
+    QCOMPARE(::objectName(model.get(2)), QString("f"));
+    QCOMPARE(::objectName(model.get(3)), QString("c"));
+
+    // Invalid moves are ignored
+    model.moveItems(0, 2, 0);
+    model.moveItems(4, 3, 0);
+
+    QCOMPARE(movedSpy.count(), 2);
+    QCOMPARE(movedSpy.at(0), QVariantList() << QModelIndex() << 0 << 1 << QModelIndex() << 5);
+    QCOMPARE(movedSpy.at(1), QVariantList() << QModelIndex() << 3 << 5 << QModelIndex() << 0);
+
+    qDeleteAll(objects);
+}
+
+void tst_ObjectListModel::testLargeSynchronization()
+{
+    const int count = 2000;
+
+    QList<QObject *> objects;
+    for (int i = 0; i < count; ++i) {
+        objects.append(makeObject(QString::number(i)));
+    }
+
+    ObjectListModel model;
+    model.synchronizeList(objects);
+    QCOMPARE(model.count(), count);
+
+    QSignalSpy addedSpy(&model, SIGNAL(itemAdded(QObject*)));
+    QSignalSpy removedSpy(&model, SIGNAL(itemRemoved(QObject*)));
+    QSignalSpy countSpy(&model, SIGNAL(countChanged()));
+
+    // Drop every third object, and move the second half before the first
+    QList<QObject *> reference;
+    for (int i = count / 2; i < count; ++i) {
+        if (i % 3)
+            reference.append(objects.at(i));
+    }
+    for (int i = 0; i < count / 2; ++i) {
+        if (i % 3)
+            reference.append(objects.at(i));
+    }
+
+    model.synchronizeList(reference);
+
+    QCOMPARE(model.count(), reference.count());
+    for (int i = 0; i < reference.count(); ++i) {
+        QCOMPARE(model.get(i), reference.at(i));
+    }
+
+    // Moved objects are reported neither as added nor removed
+    QCOMPARE(addedSpy.count(), 0);
+    QCOMPARE(removedSpy.count(), count - reference.count());
+    QCOMPARE(countSpy.count(), 1);
+
+    model.clear();
+    qDeleteAll(objects);
+}
+
+void tst_ObjectListModel::testDestroyedItems()
+{
+    ObjectListModel model;
+    model.appendItem(makeObject("a"));
+    model.appendItem(makeObject("b"));
+    model.appendItem(makeObject("c"));
+    model.appendItem(makeObject("d"));
+    model.appendItem(makeObject("e"));
+    model.appendItem(makeObject("f"));
+
+    QSignalSpy removedSpy(&model, SIGNAL(itemRemoved(QObject*)));
+    QSignalSpy countSpy(&model, SIGNAL(countChanged()));
+    QSignalSpy rowsRemovedSpy(&model, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+
+    // An item destroyed elsewhere is removed at once
+    delete model.get(1);
+
+    QCOMPARE(removedSpy.count(), 1);
+    QCOMPARE(model.count(), 5);
+    QCOMPARE(::objectName(model.get(1)), QString("c"));
+    QCOMPARE(countSpy.count(), 1);
+    QCOMPARE(rowsRemovedSpy.count(), 1);
+    QCOMPARE(rowsRemovedSpy.at(0), QVariantList() << QModelIndex() << 1 << 1);
+
+    // Items deleted together are removed together, once all of them are destroyed
+    model.deleteItems(QList<QObject *>() << model.get(1) << model.get(3) << model.get(4));
+
+    QCOMPARE(removedSpy.count(), 4);
+    QCOMPARE(model.count(), 2);
+    QCOMPARE(::objectName(model.get(0)), QString("a"));
+    QCOMPARE(::objectName(model.get(1)), QString("d"));
+
+    QCOMPARE(countSpy.count(), 2);
+    QCOMPARE(rowsRemovedSpy.count(), 3);
+    QCOMPARE(rowsRemovedSpy.at(1), QVariantList() << QModelIndex() << 3 << 4);
+    QCOMPARE(rowsRemovedSpy.at(2), QVariantList() << QModelIndex() << 1 << 1);
+
+    // Tracking the remaining items is unaffected
+    model.setNotifyChanges(true);
+    model.setNotifyChanges(false);
+    QCOMPARE(model.count(), 2);
+
+    model.deleteAll();
+    QCOMPARE(model.count(), 0);
+}
+
+void tst_ObjectListModel::testKeyedSynchronization()
+{
+    QList<QObject *> objects;
+    objects.append(makeObject("a"));
+    objects.append(makeObject("b"));
+    objects.append(makeObject("c"));
+    for (QObject *object : objects) {
+        object->setProperty("colour", QString("red"));
+    }
+
+    ObjectListModel model;
+    model.synchronizeList(objects);
+
+    // Rebuilt objects for the same records
+    QList<QObject *> rebuilt;
+    rebuilt.append(makeObject("b"));
+    rebuilt.append(makeObject("d"));
+    rebuilt.append(makeObject("a"));
+    rebuilt.at(0)->setProperty("colour", QString("blue"));
+    rebuilt.at(1)->setProperty("colour", QString("green"));
+    rebuilt.at(2)->setProperty("colour", QString("red"));
+
+    QSignalSpy addedSpy(&model, SIGNAL(itemAdded(QObject*)));
+    QSignalSpy removedSpy(&model, SIGNAL(itemRemoved(QObject*)));
+    QSignalSpy changedSpy(&model, SIGNAL(dataChanged(QModelIndex,QModelIndex)));
+
+    model.synchronizeList(rebuilt, "name");
+
+    // Existing items are kept and updated, and only objects for new keys are added
+    QCOMPARE(model.count(), 3);
+    QCOMPARE(model.get(0), objects.at(1));
+    QCOMPARE(model.get(1), rebuilt.at(1));
+    QCOMPARE(model.get(2), objects.at(0));
+    QCOMPARE(objects.at(1)->property("colour"), QVariant(QString("blue")));
+    QCOMPARE(objects.at(0)->property("colour"), QVariant(QString("red")));
+
+    QCOMPARE(addedSpy.count(), 1);
+    QCOMPARE(addedSpy.at(0), QVariantList() << QVariant::fromValue(rebuilt.at(1)));
+    QCOMPARE(removedSpy.count(), 1);
+    QCOMPARE(removedSpy.at(0), QVariantList() << QVariant::fromValue(objects.at(2)));
+
+    // Only the item whose properties differed is reported as changed
+    QCOMPARE(changedSpy.count(), 1);
+    QCOMPARE(qvariant_cast<QModelIndex>(changedSpy.at(0).at(0)).row(), 0);
+
+    model.clear();
+    qDeleteAll(objects);
+    qDeleteAll(rebuilt);
+}
+
+void tst_ObjectListModel::testBatchUpdate()
+{
+    ObjectListModel model(0, true, true);
+
+    TestObject first(QString("Istiophoridae"), QString("Istiophorus"), QString("Istiophorus albicans"));
+    TestObject second(QString("Istiophoridae"), QString("Makaira"), QString("Makaira nigricans"));
+    TestObject third(QString("Istiophoridae"), QString("Kajikia"), QString("Kajikia audax"));
+    first.setCommonName("Sailfish");
+    second.setCommonName("Blue marlin");
+    third.setCommonName("Striped marlin");
+
+    model.appendItem(&first);
+    model.appendItem(&second);
+    model.appendItem(&third);
+
+    const int commonNameRole(model.roleNames().key("commonName"));
+    QVERIFY(commonNameRole != 0);
+
+    QSignalSpy changedSpy(&model, &QAbstractItemModel::dataChanged);
+    QSignalSpy firstNotifySpy(&first, SIGNAL(commonNameChanged()));
+    QSignalSpy secondNotifySpy(&second, SIGNAL(commonNameChanged()));
+    QSignalSpy thirdNotifySpy(&third, SIGNAL(commonNameChanged()));
+
+    QVariantMap firstValues;
+    firstValues.insert(QString("commonName"), QVariant::fromValue(QString("Atlantic sailfish")));
+    QVariantMap secondValues;
+    secondValues.insert(QString("commonName"), QVariant::fromValue(QString("Blue marlin")));
+    QVariantMap thirdValues;
+    thirdValues.insert(QString("commonName"), QVariant::fromValue(QString("Striped marlin")));
+    thirdValues.insert(QString("objectName"), QVariant::fromValue(QString("Updated")));
+
+    QVERIFY(model.updateItems(QList<QObject *>() << &first << &second << &third,
+                              QList<QVariantMap>() << firstValues << secondValues << thirdValues));
+
+    QCOMPARE(first.commonName(), QString("Atlantic sailfish"));
+    QCOMPARE(third.objectName(), QString("Updated"));
+
+    // Notify signals are emitted only by the property setters, and only for changed values
+    QCOMPARE(firstNotifySpy.count(), 1);
+    QCOMPARE(secondNotifySpy.count(), 0);
+    QCOMPARE(thirdNotifySpy.count(), 0);
+
+    // Changes are reported for each contiguous run of changed rows, with the roles changed
+    QCOMPARE(changedSpy.count(), 2);
+    QCOMPARE(qvariant_cast<QModelIndex>(changedSpy.at(0).at(0)).row(), 0);
+    QCOMPARE(qvariant_cast<QModelIndex>(changedSpy.at(0).at(1)).row(), 0);
+    const QVector<int> firstRoles(qvariant_cast<QVector<int> >(changedSpy.at(0).at(2)));
+    QVERIFY(firstRoles.contains(commonNameRole));
+    QVERIFY(!firstRoles.contains(model.roleNames().key("objectName")));
+    QCOMPARE(qvariant_cast<QModelIndex>(changedSpy.at(1).at(0)).row(), 2);
+    QCOMPARE(qvariant_cast<QModelIndex>(changedSpy.at(1).at(1)).row(), 2);
+    const QVector<int> thirdRoles(qvariant_cast<QVector<int> >(changedSpy.at(1).at(2)));
+    QVERIFY(thirdRoles.contains(model.roleNames().key("objectName")));
+    QVERIFY(!thirdRoles.contains(commonNameRole));
+    QVERIFY(!thirdRoles.contains(model.roleNames().key("genus")));
+
+    // Contiguous rows with the same changed roles are reported together
+    secondValues.insert(QString("commonName"), QVariant::fromValue(QString("Atlantic blue marlin")));
+    thirdValues.insert(QString("commonName"), QVariant::fromValue(QString("Striped marlin (Pacific)")));
+    QVERIFY(model.updateItems(QList<QObject *>() << &third << &second,
+                              QList<QVariantMap>() << thirdValues << secondValues));
+    QCOMPARE(changedSpy.count(), 3);
+    QCOMPARE(qvariant_cast<QModelIndex>(changedSpy.at(2).at(0)).row(), 1);
+    QCOMPARE(qvariant_cast<QModelIndex>(changedSpy.at(2).at(1)).row(), 2);
+
+    // Unchanged values are not reported
+    QVERIFY(!model.updateItems(QList<QObject *>() << &first, QList<QVariantMap>() << firstValues));
+    QCOMPARE(changedSpy.count(), 3);
+
+    model.clear();
+}
+
 QTEST_MAIN(tst_ObjectListModel)
 
 #include "tst_objectlistmodel.moc"